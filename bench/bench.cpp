@@ -0,0 +1,558 @@
+// benchmarks for ubint and bint. sweeps the operators, sqrt, ^, factorial,
+// parsing and printing over operand sizes from one limb to millions of
+// digits, and reports the time, heap allocations and heap bytes of one
+// operation. the results can be written as json and compared against a
+// saved run, flagging the cases that got slower or allocate more
+//
+//     bench [--json out.json] [--baseline base.json] [--threshold percent]
+//           [--filter name,name,...] [--max-limbs n] [--min-time ms]
+//           [--threads n]
+//
+// the size of a case is the size of its operands in limbs, that of the
+// divisor for division and that of the result for ^ and factorial. exits
+// with 1 if a case regressed against the baseline
+
+#include <estd.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // every heap allocation of the process goes through the operators below,
+    // the limbs through the default memory resource included
+    std::atomic<std::size_t> allocations(0), allocated(0);
+
+    void *counted(std::size_t n, std::size_t alignment)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        allocated.fetch_add(n, std::memory_order_relaxed);
+
+        void *p;
+        if (alignment <= alignof(std::max_align_t))
+        {
+            p = std::malloc(n ? n : 1);
+        }
+        else
+        {
+            // aligned_alloc wants a whole number of alignments
+            p = std::aligned_alloc(alignment, (n + alignment - 1) / alignment * alignment);
+        }
+
+        if (!p)
+        {
+            throw std::bad_alloc();
+        }
+
+        return p;
+    }
+}
+
+void *operator new(std::size_t n)
+{
+    return counted(n, 0);
+}
+
+void *operator new[](std::size_t n)
+{
+    return counted(n, 0);
+}
+
+void *operator new(std::size_t n, std::align_val_t a)
+{
+    return counted(n, (std::size_t)a);
+}
+
+void *operator new[](std::size_t n, std::align_val_t a)
+{
+    return counted(n, (std::size_t)a);
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    using estd::bint;
+    using estd::ubint;
+
+    struct options
+    {
+        std::string json, baseline;
+        std::vector<std::string> filter;
+        double threshold = 10;
+        std::size_t max_limbs = std::size_t(1) << 18;
+        double min_time = 0.1;
+        std::size_t threads = 0;
+    };
+
+    struct result
+    {
+        std::string name;
+        std::size_t limbs = 0;
+        std::size_t iterations = 0;
+        double ns = 0, allocs = 0, bytes = 0;
+    };
+
+    // keeps the results of the benchmarked operations observable
+    volatile std::size_t sink;
+
+    void use(const ubint &a)
+    {
+        sink = sink + (std::size_t)null(a);
+    }
+
+    void use(const bint &a)
+    {
+        sink = sink + (std::size_t)null(a);
+    }
+
+    std::mt19937_64 &rng()
+    {
+        static std::mt19937_64 g(12345);
+        return g;
+    }
+
+    // a random number of exactly limbs limbs
+    ubint random_ubint(std::size_t limbs)
+    {
+        std::size_t n = limbs * sizeof(estd::detail::limb_t);
+        std::vector<std::byte> bytes(n);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            bytes[i] = (std::byte)rng()();
+        }
+        bytes[n - 1] |= std::byte(0x80);
+
+        return estd::import_bytes(bytes.data(), n, estd::endian::little);
+    }
+
+    bint negate(const ubint &a)
+    {
+        return bint("-" + a.value());
+    }
+
+    // the n for which n! is about limbs limbs long
+    unsigned long long factorial_argument(std::size_t limbs)
+    {
+        double bits = (double)limbs * estd::detail::limb_bits;
+        unsigned long long lo = 1, hi = 1;
+        auto size = [](unsigned long long n) { return std::lgamma((double)n + 1) / std::log(2.0); };
+        while (size(hi) < bits)
+        {
+            hi *= 2;
+        }
+        while (lo < hi)
+        {
+            unsigned long long mid = lo + (hi - lo) / 2;
+            if (size(mid) < bits)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+
+        return lo;
+    }
+
+    // run f until the runs take min_time seconds in total, after one run to
+    // warm up the caches and the scratch memory
+    result measure(const std::string &name, std::size_t limbs, double min_time, const std::function<void()> &f)
+    {
+        typedef std::chrono::steady_clock clock;
+
+        f();
+        std::size_t iterations = 1;
+        for (;;)
+        {
+            std::size_t a = allocations.load(), b = allocated.load();
+            clock::time_point t0 = clock::now();
+            for (std::size_t i = 0; i < iterations; i++)
+            {
+                f();
+            }
+            double t = std::chrono::duration<double>(clock::now() - t0).count();
+            std::size_t da = allocations.load() - a, db = allocated.load() - b;
+
+            if (t >= min_time || iterations >= (std::size_t(1) << 30))
+            {
+                result r;
+                r.name = name;
+                r.limbs = limbs;
+                r.iterations = iterations;
+                r.ns = t * 1e9 / iterations;
+                r.allocs = (double)da / iterations;
+                r.bytes = (double)db / iterations;
+                return r;
+            }
+
+            // aim a little past min_time, growing at least twofold
+            double scale = t > 0 ? 1.2 * min_time / t : 100;
+            iterations = std::max(iterations * 2, (std::size_t)(iterations * std::min(scale, 100.0)));
+        }
+    }
+
+    // a benchmark of one operation at a given size. setup builds the
+    // operands outside the timing and returns the operation to time
+    struct benchmark
+    {
+        std::string name;
+        std::function<std::function<void()>(std::size_t)> setup;
+    };
+
+    std::vector<benchmark> benchmarks()
+    {
+        std::vector<benchmark> b;
+
+        auto binary = [&b](const std::string &name, std::size_t scale, std::function<void(const ubint &, const ubint &)> op)
+        {
+            // the first operand is scale times as long as the second
+            b.push_back({name, [scale, op](std::size_t limbs) -> std::function<void()>
+            {
+                ubint x = random_ubint(limbs * scale), y = random_ubint(limbs);
+                return [x, y, op]() { op(x, y); };
+            }});
+        };
+
+        binary("add", 1, [](const ubint &x, const ubint &y) { use(x + y); });
+        binary("sub", 1, [](const ubint &x, const ubint &y) { use(x > y ? x - y : y - x); });
+        binary("mul", 1, [](const ubint &x, const ubint &y) { use(x * y); });
+        binary("sqr", 1, [](const ubint &x, const ubint &) { use(x * x); });
+        binary("div", 2, [](const ubint &x, const ubint &y) { use(x / y); });
+        binary("mod", 2, [](const ubint &x, const ubint &y) { use(x % y); });
+        binary("shl", 1, [](const ubint &x, const ubint &) { use(x << std::size_t(37)); });
+        binary("shr", 1, [](const ubint &x, const ubint &) { use(x >> std::size_t(37)); });
+        binary("cmp", 1, [](const ubint &x, const ubint &y) { sink = sink + (std::size_t)(x < y); });
+        binary("gcd", 1, [](const ubint &x, const ubint &y) { use(gcd(x, y)); });
+        binary("sqrt", 1, [](const ubint &x, const ubint &) { use(sqrt(x)); });
+
+        b.push_back({"pow", [](std::size_t limbs) -> std::function<void()>
+        {
+            // a one limb base to the power of limbs is about limbs limbs long
+            ubint x = random_ubint(1), e((unsigned long long)limbs);
+            return [x, e]() { use(x ^ e); };
+        }});
+        b.push_back({"factorial", [](std::size_t limbs) -> std::function<void()>
+        {
+            ubint n(factorial_argument(limbs));
+            return [n]() { use(factorial(n)); };
+        }});
+        b.push_back({"parse", [](std::size_t limbs) -> std::function<void()>
+        {
+            std::string s = random_ubint(limbs).value();
+            return [s]() { use(ubint(s)); };
+        }});
+        b.push_back({"print", [](std::size_t limbs) -> std::function<void()>
+        {
+            ubint x = random_ubint(limbs);
+            return [x]() { sink = sink + x.value().size(); };
+        }});
+        b.push_back({"bint_add", [](std::size_t limbs) -> std::function<void()>
+        {
+            // opposite signs, so the magnitudes are subtracted
+            bint x = negate(random_ubint(limbs)), y(random_ubint(limbs).value());
+            return [x, y]() { use(x + y); };
+        }});
+        b.push_back({"bint_mul", [](std::size_t limbs) -> std::function<void()>
+        {
+            bint x = negate(random_ubint(limbs)), y(random_ubint(limbs).value());
+            return [x, y]() { use(x * y); };
+        }});
+
+        return b;
+    }
+
+    bool selected(const options &o, const std::string &name)
+    {
+        return o.filter.empty() || std::find(o.filter.begin(), o.filter.end(), name) != o.filter.end();
+    }
+
+    void write_json(const options &o, const std::vector<result> &results)
+    {
+        std::ofstream out(o.json);
+        if (!out)
+        {
+            std::fprintf(stderr, "cannot write %s\n", o.json.c_str());
+            std::exit(2);
+        }
+
+        out << "{\n";
+        out << "  \"limb_bits\": " << estd::detail::limb_bits << ",\n";
+        out << "  \"threads\": " << estd::get_thread_count() << ",\n";
+        out << "  \"kernels\": \"" << (estd::get_limb_kernels() == estd::limb_kernels::adx ? "adx" : "portable") << "\",\n";
+        out << "  \"benchmarks\": [\n";
+        for (std::size_t i = 0; i < results.size(); i++)
+        {
+            const result &r = results[i];
+            char line[512];
+            std::snprintf(line, sizeof(line),
+                "    {\"name\": \"%s\", \"limbs\": %zu, \"iterations\": %zu, \"ns_per_op\": %.1f, \"allocs_per_op\": %.2f, \"bytes_per_op\": %.1f}%s\n",
+                r.name.c_str(), r.limbs, r.iterations, r.ns, r.allocs, r.bytes, i + 1 < results.size() ? "," : "");
+            out << line;
+        }
+        out << "  ]\n}\n";
+    }
+
+    // read the benchmarks of a file written by write_json. only the flat
+    // objects in it matter, so a scan for their string and number fields is
+    // enough
+    std::vector<result> read_json(const std::string &path)
+    {
+        std::ifstream in(path);
+        if (!in)
+        {
+            std::fprintf(stderr, "cannot read %s\n", path.c_str());
+            std::exit(2);
+        }
+
+        std::stringstream ss;
+        ss << in.rdbuf();
+        const std::string s = ss.str();
+
+        std::vector<result> results;
+        std::map<std::string, std::string> fields;
+        bool inside = false;
+        for (std::size_t i = 0; i < s.size(); i++)
+        {
+            if (s[i] == '{')
+            {
+                inside = true;
+                fields.clear();
+            }
+            else if (s[i] == '}' && inside)
+            {
+                inside = false;
+                if (fields.count("name") && fields.count("limbs") && fields.count("ns_per_op"))
+                {
+                    result r;
+                    r.name = fields["name"];
+                    r.limbs = std::strtoull(fields["limbs"].c_str(), nullptr, 10);
+                    r.ns = std::strtod(fields["ns_per_op"].c_str(), nullptr);
+                    r.allocs = std::strtod(fields["allocs_per_op"].c_str(), nullptr);
+                    r.bytes = std::strtod(fields["bytes_per_op"].c_str(), nullptr);
+                    results.push_back(r);
+                }
+            }
+            else if (s[i] == '"' && inside)
+            {
+                // "key": value, where the value is a string or a number
+                std::size_t e = s.find('"', i + 1);
+                std::size_t c = s.find(':', e);
+                if (e == std::string::npos || c == std::string::npos)
+                {
+                    break;
+                }
+
+                std::string key = s.substr(i + 1, e - i - 1);
+                std::size_t v = s.find_first_not_of(" \t\r\n", c + 1);
+                if (v == std::string::npos)
+                {
+                    break;
+                }
+
+                std::size_t end;
+                if (s[v] == '"')
+                {
+                    end = s.find('"', v + 1);
+                    fields[key] = s.substr(v + 1, end - v - 1);
+                    end++;
+                }
+                else
+                {
+                    end = s.find_first_of(",}\n", v);
+                    fields[key] = s.substr(v, end - v);
+                }
+                i = end - 1;
+            }
+        }
+
+        return results;
+    }
+
+    void usage()
+    {
+        std::fprintf(stderr,
+            "usage: bench [options]\n"
+            "  --json file        write the results as json\n"
+            "  --baseline file    compare against the json of an earlier run\n"
+            "  --threshold pct    slowdown that counts as a regression, 10 by default\n"
+            "  --filter a,b,...   only run the named benchmarks\n"
+            "  --max-limbs n      largest operand size, 262144 by default\n"
+            "  --min-time ms      time to spend on each case, 100 by default\n"
+            "  --threads n        threads for large products, all by default\n");
+        std::exit(2);
+    }
+
+    options parse(int argc, char **argv)
+    {
+        options o;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string a = argv[i];
+            if (i + 1 >= argc)
+            {
+                usage();
+            }
+
+            std::string v = argv[++i];
+            if (a == "--json")
+            {
+                o.json = v;
+            }
+            else if (a == "--baseline")
+            {
+                o.baseline = v;
+            }
+            else if (a == "--threshold")
+            {
+                o.threshold = std::strtod(v.c_str(), nullptr);
+            }
+            else if (a == "--filter")
+            {
+                std::stringstream ss(v);
+                for (std::string name; std::getline(ss, name, ',');)
+                {
+                    o.filter.push_back(name);
+                }
+            }
+            else if (a == "--max-limbs")
+            {
+                o.max_limbs = std::strtoull(v.c_str(), nullptr, 10);
+            }
+            else if (a == "--min-time")
+            {
+                o.min_time = std::strtod(v.c_str(), nullptr) / 1000;
+            }
+            else if (a == "--threads")
+            {
+                o.threads = std::strtoull(v.c_str(), nullptr, 10);
+            }
+            else
+            {
+                usage();
+            }
+        }
+
+        return o;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    options o = parse(argc, argv);
+    estd::set_thread_count(o.threads);
+
+    std::vector<result> base;
+    if (!o.baseline.empty())
+    {
+        base = read_json(o.baseline);
+    }
+
+    std::printf("%-10s %8s %10s %14s %10s %14s", "name", "limbs", "digits", "ns/op", "allocs/op", "bytes/op");
+    std::printf(base.empty() ? "\n" : " %9s\n", "vs base");
+
+    std::vector<result> results;
+    int regressions = 0;
+    for (const benchmark &b : benchmarks())
+    {
+        if (!selected(o, b.name))
+        {
+            continue;
+        }
+
+        for (std::size_t limbs = 1; limbs <= o.max_limbs; limbs *= 4)
+        {
+            result r = measure(b.name, limbs, o.min_time, b.setup(limbs));
+            results.push_back(r);
+
+            std::size_t digits = (std::size_t)(limbs * estd::detail::limb_bits * std::log10(2.0)) + 1;
+            std::printf("%-10s %8zu %10zu %14.1f %10.2f %14.1f", r.name.c_str(), r.limbs, digits, r.ns, r.allocs, r.bytes);
+
+            const result *old = nullptr;
+            for (const result &x : base)
+            {
+                if (x.name == r.name && x.limbs == r.limbs)
+                {
+                    old = &x;
+                }
+            }
+
+            if (old)
+            {
+                // slower past the threshold, or more allocations at all
+                double ratio = r.ns / old->ns;
+                bool slower = ratio > 1 + o.threshold / 100;
+                bool allocs = r.allocs > old->allocs + 0.5;
+                std::printf(" %8.2fx%s%s", ratio, slower ? "  SLOWER" : "", allocs ? "  MORE ALLOCATIONS" : "");
+                regressions += (slower || allocs);
+            }
+            std::printf("\n");
+            std::fflush(stdout);
+        }
+    }
+
+    if (!o.json.empty())
+    {
+        write_json(o, results);
+    }
+
+    if (!base.empty())
+    {
+        std::printf("%d regression%s against %s\n", regressions, regressions == 1 ? "" : "s", o.baseline.c_str());
+    }
+
+    return regressions ? 1 : 0;
+}
@@ -0,0 +1,562 @@
+#ifndef batch_hpp
+#define batch_hpp
+
+#include <ubint.hpp>
+
+#if defined(__SIZEOF_INT128__) && (defined(__AVX2__) || defined(__AVX512F__))
+#include <immintrin.h>
+#endif
+
+namespace estd
+{
+    // count unsigned numbers of the same number of limbs, stored structure of
+    // arrays: limb i of every number is contiguous, so one vector instruction
+    // advances limb i of several numbers at once. the kernels below work
+    // modulo B^limbs, B = 2^limb_bits, and hand back what is carried out of
+    // each number. they use avx-512 or avx2 when the compiler targets them
+    // (-mavx2, -march=native, ...) and portable loops otherwise
+    class ubint_batch
+    {
+    public:
+        // an empty batch
+        ubint_batch();
+        // count zeros of limbs limbs each, allocated from r or from the
+        // current get_memory_resource() if r is null
+        ubint_batch(std::size_t count, std::size_t limbs, memory_resource *r = nullptr);
+        // copies allocate from the resource of b
+        ubint_batch(const ubint_batch &b);
+        // takes the limbs of b, leaving it empty
+        ubint_batch(ubint_batch &&b) noexcept;
+        ~ubint_batch();
+        ubint_batch &operator=(const ubint_batch &b);
+        ubint_batch &operator=(ubint_batch &&b) noexcept;
+
+        // the number of numbers
+        std::size_t size() const;
+        // the limbs of every number
+        std::size_t limbs() const;
+        // the distance between limb i and limb i + 1 of a number, size()
+        // rounded up to the widest vector of limbs
+        std::size_t stride() const;
+        // limb i of every number, size() of them
+        detail::limb_t *row(std::size_t i);
+        const detail::limb_t *row(std::size_t i) const;
+
+        // number j
+        ubint get(std::size_t j) const;
+        // set number j to a. throws if a needs more than limbs() limbs
+        void set(std::size_t j, const ubint &a);
+
+        // the resource the limbs are allocated from
+        memory_resource *resource() const;
+
+    private:
+        // limb i of number j is at data[i * pitch + j]
+        detail::limb_t *data;
+        std::size_t count, len, pitch;
+        memory_resource *res;
+
+        // free the limbs, leaving the batch empty
+        void release();
+    };
+
+    // r = a + b for every number. carry, if not null, gets the carry out of
+    // each of the size() numbers. a and b must have the same shape, and r is
+    // given it if it has another. r may be a or b
+    void add(ubint_batch &r, const ubint_batch &a, const ubint_batch &b, detail::limb_t *carry = nullptr);
+    // r = a - b for every number. borrow, if not null, gets 1 where a < b
+    void sub(ubint_batch &r, const ubint_batch &a, const ubint_batch &b, detail::limb_t *borrow = nullptr);
+    // r = a * k for every number. high, if not null, gets the limb of each
+    // product above limbs()
+    void mul(ubint_batch &r, const ubint_batch &a, detail::limb_t k, detail::limb_t *high = nullptr);
+    // c[j] = -1, 0 or 1 as number j of a is less than, equal to or greater
+    // than number j of b
+    void cmp(const ubint_batch &a, const ubint_batch &b, int *c);
+
+    namespace detail
+    {
+        // the rows of a batch are padded to a multiple of this many lanes, the
+        // limbs of the widest vector, so the kernels need no scalar tail
+        const std::size_t batch_lanes = 8;
+
+        // the kernels take rows rows of stride lanes, one number per lane,
+        // and work on blocks of batch_lanes lanes from the bottom row up, so
+        // the carries stay in registers. only the first lanes lanes of the
+        // carry outputs are written
+
+        // r = a + b. carry, if not null, gets the carries out
+        void batch_add(limb_t *r, const limb_t *a, const limb_t *b, std::size_t rows, std::size_t stride, std::size_t lanes, limb_t *carry);
+        // r = a - b. borrow, if not null, gets the borrows out
+        void batch_sub(limb_t *r, const limb_t *a, const limb_t *b, std::size_t rows, std::size_t stride, std::size_t lanes, limb_t *borrow);
+        // r = a * k. high, if not null, gets the limbs carried out
+        void batch_mul_1(limb_t *r, const limb_t *a, limb_t k, std::size_t rows, std::size_t stride, std::size_t lanes, limb_t *high);
+        // c = the comparison of a and b, -1, 0 or 1 in each lane
+        void batch_cmp(const limb_t *a, const limb_t *b, std::size_t rows, std::size_t stride, std::size_t lanes, int *c);
+
+        // throw unless a and b have the same shape
+        void batch_check(const ubint_batch &a, const ubint_batch &b);
+        // give r the shape of a, if it has another
+        void batch_shape(ubint_batch &r, const ubint_batch &a);
+
+    #if defined(__SIZEOF_INT128__) && defined(__AVX2__) && !defined(__AVX512F__)
+        // all ones in the lanes where x < y as unsigned numbers. avx2 only
+        // compares signed, so both sides get their top bit flipped
+        __m256i batch_lt(__m256i x, __m256i y);
+    #endif
+
+    #if defined(__SIZEOF_INT128__) && defined(__AVX512F__)
+        // lo and hi of x * k + c in each lane, from 32 bit products, with k
+        // split into its halves kl and kh. with half the lanes and no
+        // unsigned compare the same loses to scalar products on avx2, so
+        // batch_mul_1 only vectorizes on avx-512
+        void batch_mul(__m512i x, __m512i kl, __m512i kh, __m512i c, __m512i &lo, __m512i &hi);
+    #endif
+
+    #if defined(__SIZEOF_INT128__) && defined(__AVX2__) && !defined(__AVX512F__)
+        __m256i batch_lt(__m256i x, __m256i y)
+        {
+            const __m256i s = _mm256_set1_epi64x(INT64_MIN);
+            return _mm256_cmpgt_epi64(_mm256_xor_si256(y, s), _mm256_xor_si256(x, s));
+        }
+    #endif
+
+    #if defined(__SIZEOF_INT128__) && defined(__AVX512F__)
+        void batch_mul(__m512i x, __m512i kl, __m512i kh, __m512i c, __m512i &lo, __m512i &hi)
+        {
+            const __m512i m = _mm512_set1_epi64(0xffffffff);
+            __m512i xh = _mm512_srli_epi64(x, 32);
+            __m512i p0 = _mm512_mul_epu32(x, kl), p1 = _mm512_mul_epu32(x, kh);
+            __m512i p2 = _mm512_mul_epu32(xh, kl), p3 = _mm512_mul_epu32(xh, kh);
+            // the middle column of the product, at most 34 bits
+            __m512i t = _mm512_add_epi64(_mm512_srli_epi64(p0, 32), _mm512_and_si512(p1, m));
+            t = _mm512_add_epi64(t, _mm512_and_si512(p2, m));
+            lo = _mm512_or_si512(_mm512_and_si512(p0, m), _mm512_slli_epi64(t, 32));
+            hi = _mm512_add_epi64(p3, _mm512_srli_epi64(t, 32));
+            hi = _mm512_add_epi64(hi, _mm512_add_epi64(_mm512_srli_epi64(p1, 32), _mm512_srli_epi64(p2, 32)));
+            // x * k + c < B^2, so the carry into hi never overflows it
+            lo = _mm512_add_epi64(lo, c);
+            hi = _mm512_mask_add_epi64(hi, _mm512_cmplt_epu64_mask(lo, c), hi, _mm512_set1_epi64(1));
+        }
+    #endif
+
+        void batch_add(limb_t *r, const limb_t *a, const limb_t *b, std::size_t rows, std::size_t stride, std::size_t lanes, limb_t *carry)
+        {
+            for (std::size_t j = 0; j < stride; j += batch_lanes)
+            {
+                limb_t c[batch_lanes] = {};
+            #if defined(__SIZEOF_INT128__) && defined(__AVX512F__)
+                const __m512i one = _mm512_set1_epi64(1), ones = _mm512_set1_epi64(-1);
+                __mmask8 k = 0;
+                for (std::size_t i = 0; i < rows; i++)
+                {
+                    std::size_t o = i * stride + j;
+                    __m512i x = _mm512_load_si512(a + o), y = _mm512_load_si512(b + o);
+                    __m512i s = _mm512_add_epi64(x, y);
+                    // carry out of x + y, or of adding the carry in to all ones
+                    __mmask8 k1 = _mm512_cmplt_epu64_mask(s, x);
+                    __mmask8 k2 = _mm512_mask_cmpeq_epu64_mask(k, s, ones);
+                    _mm512_store_si512(r + o, _mm512_mask_add_epi64(s, k, s, one));
+                    k = k1 | k2;
+                }
+                _mm512_storeu_si512(c, _mm512_maskz_mov_epi64(k, one));
+            #elif defined(__SIZEOF_INT128__) && defined(__AVX2__)
+                // carries as all ones lanes, so subtracting one adds it
+                __m256i k0 = _mm256_setzero_si256(), k1 = k0;
+                for (std::size_t i = 0; i < rows; i++)
+                {
+                    limb_t *z = r + i * stride + j;
+                    const limb_t *x = a + i * stride + j, *y = b + i * stride + j;
+                    __m256i x0 = _mm256_load_si256((const __m256i *)x), x1 = _mm256_load_si256((const __m256i *)(x + 4));
+                    __m256i s0 = _mm256_add_epi64(x0, _mm256_load_si256((const __m256i *)y));
+                    __m256i s1 = _mm256_add_epi64(x1, _mm256_load_si256((const __m256i *)(y + 4)));
+                    __m256i c0 = batch_lt(s0, x0), c1 = batch_lt(s1, x1);
+                    s0 = _mm256_sub_epi64(s0, k0);
+                    s1 = _mm256_sub_epi64(s1, k1);
+                    k0 = _mm256_or_si256(c0, _mm256_and_si256(k0, _mm256_cmpeq_epi64(s0, _mm256_setzero_si256())));
+                    k1 = _mm256_or_si256(c1, _mm256_and_si256(k1, _mm256_cmpeq_epi64(s1, _mm256_setzero_si256())));
+                    _mm256_store_si256((__m256i *)z, s0);
+                    _mm256_store_si256((__m256i *)(z + 4), s1);
+                }
+                _mm256_storeu_si256((__m256i *)c, _mm256_srli_epi64(k0, 63));
+                _mm256_storeu_si256((__m256i *)(c + 4), _mm256_srli_epi64(k1, 63));
+            #else
+                // lane by lane, which keeps the carry in a register. the
+                // rows of a block share cache lines, so the stride costs little
+                for (std::size_t l = 0; l < batch_lanes; l++)
+                {
+                    limb_t k = 0;
+                    for (std::size_t i = 0, o = j + l; i < rows; i++, o += stride)
+                    {
+                        limb_t s = a[o] + k;
+                        limb_t c1 = s < k;
+                        s += b[o];
+                        k = c1 + (s < b[o]);
+                        r[o] = s;
+                    }
+                    c[l] = k;
+                }
+            #endif
+                if (carry)
+                {
+                    for (std::size_t l = 0; l < batch_lanes && j + l < lanes; l++)
+                    {
+                        carry[j + l] = c[l];
+                    }
+                }
+            }
+        }
+
+        void batch_sub(limb_t *r, const limb_t *a, const limb_t *b, std::size_t rows, std::size_t stride, std::size_t lanes, limb_t *borrow)
+        {
+            for (std::size_t j = 0; j < stride; j += batch_lanes)
+            {
+                limb_t c[batch_lanes] = {};
+            #if defined(__SIZEOF_INT128__) && defined(__AVX512F__)
+                const __m512i one = _mm512_set1_epi64(1);
+                __mmask8 k = 0;
+                for (std::size_t i = 0; i < rows; i++)
+                {
+                    std::size_t o = i * stride + j;
+                    __m512i x = _mm512_load_si512(a + o), y = _mm512_load_si512(b + o);
+                    __m512i d = _mm512_sub_epi64(x, y);
+                    // borrow out of x - y, or of taking the borrow in from zero
+                    __mmask8 k1 = _mm512_cmplt_epu64_mask(x, y);
+                    __mmask8 k2 = _mm512_mask_cmpeq_epu64_mask(k, d, _mm512_setzero_si512());
+                    _mm512_store_si512(r + o, _mm512_mask_sub_epi64(d, k, d, one));
+                    k = k1 | k2;
+                }
+                _mm512_storeu_si512(c, _mm512_maskz_mov_epi64(k, one));
+            #elif defined(__SIZEOF_INT128__) && defined(__AVX2__)
+                // borrows as all ones lanes, so adding one subtracts it
+                __m256i k0 = _mm256_setzero_si256(), k1 = k0;
+                for (std::size_t i = 0; i < rows; i++)
+                {
+                    limb_t *z = r + i * stride + j;
+                    const limb_t *x = a + i * stride + j, *y = b + i * stride + j;
+                    __m256i x0 = _mm256_load_si256((const __m256i *)x), x1 = _mm256_load_si256((const __m256i *)(x + 4));
+                    __m256i y0 = _mm256_load_si256((const __m256i *)y), y1 = _mm256_load_si256((const __m256i *)(y + 4));
+                    __m256i d0 = _mm256_sub_epi64(x0, y0), d1 = _mm256_sub_epi64(x1, y1);
+                    __m256i c0 = batch_lt(x0, y0), c1 = batch_lt(x1, y1);
+                    c0 = _mm256_or_si256(c0, _mm256_and_si256(k0, _mm256_cmpeq_epi64(d0, _mm256_setzero_si256())));
+                    c1 = _mm256_or_si256(c1, _mm256_and_si256(k1, _mm256_cmpeq_epi64(d1, _mm256_setzero_si256())));
+                    _mm256_store_si256((__m256i *)z, _mm256_add_epi64(d0, k0));
+                    _mm256_store_si256((__m256i *)(z + 4), _mm256_add_epi64(d1, k1));
+                    k0 = c0;
+                    k1 = c1;
+                }
+                _mm256_storeu_si256((__m256i *)c, _mm256_srli_epi64(k0, 63));
+                _mm256_storeu_si256((__m256i *)(c + 4), _mm256_srli_epi64(k1, 63));
+            #else
+                for (std::size_t l = 0; l < batch_lanes; l++)
+                {
+                    limb_t k = 0;
+                    for (std::size_t i = 0, o = j + l; i < rows; i++, o += stride)
+                    {
+                        limb_t d = a[o] - b[o];
+                        limb_t c1 = a[o] < b[o];
+                        r[o] = d - k;
+                        k = c1 + (d < k);
+                    }
+                    c[l] = k;
+                }
+            #endif
+                if (borrow)
+                {
+                    for (std::size_t l = 0; l < batch_lanes && j + l < lanes; l++)
+                    {
+                        borrow[j + l] = c[l];
+                    }
+                }
+            }
+        }
+
+        void batch_mul_1(limb_t *r, const limb_t *a, limb_t k, std::size_t rows, std::size_t stride, std::size_t lanes, limb_t *high)
+        {
+            for (std::size_t j = 0; j < stride; j += batch_lanes)
+            {
+                limb_t c[batch_lanes] = {};
+            #if defined(__SIZEOF_INT128__) && defined(__AVX512F__)
+                const __m512i kl = _mm512_set1_epi64(k & 0xffffffff), kh = _mm512_set1_epi64(k >> 32);
+                __m512i h = _mm512_setzero_si512();
+                for (std::size_t i = 0; i < rows; i++)
+                {
+                    std::size_t o = i * stride + j;
+                    __m512i lo;
+                    batch_mul(_mm512_load_si512(a + o), kl, kh, h, lo, h);
+                    _mm512_store_si512(r + o, lo);
+                }
+                _mm512_storeu_si512(c, h);
+            #else
+                for (std::size_t l = 0; l < batch_lanes; l++)
+                {
+                    limb_t h = 0;
+                    for (std::size_t i = 0, o = j + l; i < rows; i++, o += stride)
+                    {
+                        dlimb_t p = (dlimb_t)a[o] * k + h;
+                        r[o] = (limb_t)p;
+                        h = (limb_t)(p >> limb_bits);
+                    }
+                    c[l] = h;
+                }
+            #endif
+                if (high)
+                {
+                    for (std::size_t l = 0; l < batch_lanes && j + l < lanes; l++)
+                    {
+                        high[j + l] = c[l];
+                    }
+                }
+            }
+        }
+
+        void batch_cmp(const limb_t *a, const limb_t *b, std::size_t rows, std::size_t stride, std::size_t lanes, int *c)
+        {
+            for (std::size_t j = 0; j < stride; j += batch_lanes)
+            {
+                // from the top row down the first difference decides, and a
+                // block stops once every lane is decided
+                long long v[batch_lanes] = {};
+            #if defined(__SIZEOF_INT128__) && defined(__AVX512F__)
+                __m512i s = _mm512_setzero_si512();
+                __mmask8 done = 0;
+                for (std::size_t i = rows; i-- > 0 && done != 0xff;)
+                {
+                    std::size_t o = i * stride + j;
+                    __m512i x = _mm512_load_si512(a + o), y = _mm512_load_si512(b + o);
+                    __mmask8 gt = _mm512_mask_cmpgt_epu64_mask(~done, x, y);
+                    __mmask8 lt = _mm512_mask_cmplt_epu64_mask(~done, x, y);
+                    s = _mm512_mask_mov_epi64(s, gt, _mm512_set1_epi64(1));
+                    s = _mm512_mask_mov_epi64(s, lt, _mm512_set1_epi64(-1));
+                    done |= gt | lt;
+                }
+                _mm512_storeu_si512(v, s);
+            #elif defined(__SIZEOF_INT128__) && defined(__AVX2__)
+                const __m256i one = _mm256_set1_epi64x(1), zero = _mm256_setzero_si256();
+                __m256i s0 = zero, s1 = zero;
+                for (std::size_t i = rows; i-- > 0;)
+                {
+                    const limb_t *x = a + i * stride + j, *y = b + i * stride + j;
+                    __m256i x0 = _mm256_load_si256((const __m256i *)x), x1 = _mm256_load_si256((const __m256i *)(x + 4));
+                    __m256i y0 = _mm256_load_si256((const __m256i *)y), y1 = _mm256_load_si256((const __m256i *)(y + 4));
+                    // 1 where x > y, all ones (-1) where x < y
+                    __m256i d0 = _mm256_or_si256(_mm256_and_si256(batch_lt(y0, x0), one), batch_lt(x0, y0));
+                    __m256i d1 = _mm256_or_si256(_mm256_and_si256(batch_lt(y1, x1), one), batch_lt(x1, y1));
+                    __m256i u0 = _mm256_cmpeq_epi64(s0, zero), u1 = _mm256_cmpeq_epi64(s1, zero);
+                    s0 = _mm256_or_si256(s0, _mm256_and_si256(u0, d0));
+                    s1 = _mm256_or_si256(s1, _mm256_and_si256(u1, d1));
+                    if (!_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi64(s0, zero), _mm256_cmpeq_epi64(s1, zero))))
+                    {
+                        break;
+                    }
+                }
+                _mm256_storeu_si256((__m256i *)v, s0);
+                _mm256_storeu_si256((__m256i *)(v + 4), s1);
+            #else
+                std::size_t left = batch_lanes;
+                for (std::size_t i = rows; i-- > 0 && left;)
+                {
+                    const limb_t *x = a + i * stride + j, *y = b + i * stride + j;
+                    for (std::size_t l = 0; l < batch_lanes; l++)
+                    {
+                        if (!v[l] && x[l] != y[l])
+                        {
+                            v[l] = x[l] < y[l] ? -1 : 1;
+                            left--;
+                        }
+                    }
+                }
+            #endif
+                for (std::size_t l = 0; l < batch_lanes && j + l < lanes; l++)
+                {
+                    c[j + l] = (int)v[l];
+                }
+            }
+        }
+
+        void batch_check(const ubint_batch &a, const ubint_batch &b)
+        {
+            if (a.size() != b.size() || a.limbs() != b.limbs())
+            {
+                throw std::invalid_argument("batches must have the same shape");
+            }
+        }
+
+        void batch_shape(ubint_batch &r, const ubint_batch &a)
+        {
+            if (r.size() != a.size() || r.limbs() != a.limbs())
+            {
+                r = ubint_batch(a.size(), a.limbs(), r.resource());
+            }
+        }
+    }
+
+    ubint_batch::ubint_batch() : data(nullptr), count(0), len(0), pitch(0), res(get_memory_resource()) {}
+
+    ubint_batch::ubint_batch(std::size_t count, std::size_t limbs, memory_resource *r) : data(nullptr), count(count), len(limbs), pitch(0), res(r ? r : get_memory_resource())
+    {
+        pitch = (count + detail::batch_lanes - 1) / detail::batch_lanes * detail::batch_lanes;
+        if (pitch && len)
+        {
+            if (len > SIZE_MAX / sizeof(detail::limb_t) / pitch)
+            {
+                throw std::length_error("batch too large");
+            }
+            // aligned to the vector width, as every row starts a block
+            std::size_t n = len * pitch;
+            data = static_cast<detail::limb_t *>(res->allocate(n * sizeof(detail::limb_t), detail::batch_lanes * sizeof(detail::limb_t)));
+            std::fill(data, data + n, 0);
+        }
+    }
+
+    ubint_batch::ubint_batch(const ubint_batch &b) : ubint_batch(b.count, b.len, b.res)
+    {
+        if (data)
+        {
+            std::copy(b.data, b.data + len * pitch, data);
+        }
+    }
+
+    ubint_batch::ubint_batch(ubint_batch &&b) noexcept : data(b.data), count(b.count), len(b.len), pitch(b.pitch), res(b.res)
+    {
+        b.data = nullptr;
+        b.count = b.len = b.pitch = 0;
+    }
+
+    ubint_batch::~ubint_batch()
+    {
+        release();
+    }
+
+    ubint_batch &ubint_batch::operator=(const ubint_batch &b)
+    {
+        if (this != &b)
+        {
+            // keep the limbs if the shape is the same, and the resource anyway.
+            // t takes the old limbs with their shape, so it frees them right
+            if (count != b.count || len != b.len)
+            {
+                ubint_batch t(b.count, b.len, res);
+                std::swap(data, t.data);
+                std::swap(count, t.count);
+                std::swap(len, t.len);
+                std::swap(pitch, t.pitch);
+            }
+            if (data)
+            {
+                std::copy(b.data, b.data + len * pitch, data);
+            }
+        }
+        return *this;
+    }
+
+    ubint_batch &ubint_batch::operator=(ubint_batch &&b) noexcept
+    {
+        if (this != &b)
+        {
+            release();
+            data = b.data;
+            count = b.count;
+            len = b.len;
+            pitch = b.pitch;
+            res = b.res;
+            b.data = nullptr;
+            b.count = b.len = b.pitch = 0;
+        }
+        return *this;
+    }
+
+    void ubint_batch::release()
+    {
+        if (data)
+        {
+            res->deallocate(data, len * pitch * sizeof(detail::limb_t), detail::batch_lanes * sizeof(detail::limb_t));
+            data = nullptr;
+        }
+        count = len = pitch = 0;
+    }
+
+    std::size_t ubint_batch::size() const
+    {
+        return count;
+    }
+
+    std::size_t ubint_batch::limbs() const
+    {
+        return len;
+    }
+
+    std::size_t ubint_batch::stride() const
+    {
+        return pitch;
+    }
+
+    detail::limb_t *ubint_batch::row(std::size_t i)
+    {
+        return data + i * pitch;
+    }
+
+    const detail::limb_t *ubint_batch::row(std::size_t i) const
+    {
+        return data + i * pitch;
+    }
+
+    ubint ubint_batch::get(std::size_t j) const
+    {
+        ubint r(0ULL, res);
+        detail::limb_vector &v = detail::ubint_access::limbs(r);
+        v.resize(len);
+        for (std::size_t i = 0; i < len; i++)
+        {
+            v[i] = data[i * pitch + j];
+        }
+        detail::ubint_access::trim(r);
+
+        return r;
+    }
+
+    void ubint_batch::set(std::size_t j, const ubint &a)
+    {
+        const detail::limb_vector &v = detail::ubint_access::limbs(a);
+        if (v.size() > len)
+        {
+            throw std::overflow_error("number too large for the batch");
+        }
+        for (std::size_t i = 0; i < len; i++)
+        {
+            data[i * pitch + j] = i < v.size() ? v[i] : 0;
+        }
+    }
+
+    memory_resource *ubint_batch::resource() const
+    {
+        return res;
+    }
+
+    void add(ubint_batch &r, const ubint_batch &a, const ubint_batch &b, detail::limb_t *carry)
+    {
+        detail::batch_check(a, b);
+        detail::batch_shape(r, a);
+        detail::batch_add(r.row(0), a.row(0), b.row(0), a.limbs(), a.stride(), a.size(), carry);
+    }
+
+    void sub(ubint_batch &r, const ubint_batch &a, const ubint_batch &b, detail::limb_t *borrow)
+    {
+        detail::batch_check(a, b);
+        detail::batch_shape(r, a);
+        detail::batch_sub(r.row(0), a.row(0), b.row(0), a.limbs(), a.stride(), a.size(), borrow);
+    }
+
+    void mul(ubint_batch &r, const ubint_batch &a, detail::limb_t k, detail::limb_t *high)
+    {
+        detail::batch_shape(r, a);
+        detail::batch_mul_1(r.row(0), a.row(0), k, a.limbs(), a.stride(), a.size(), high);
+    }
+
+    void cmp(const ubint_batch &a, const ubint_batch &b, int *c)
+    {
+        detail::batch_check(a, b);
+        detail::batch_cmp(a.row(0), b.row(0), a.limbs(), a.stride(), a.size(), c);
+    }
+}
+
+#endif
@@ -0,0 +1,418 @@
+#ifndef binary_hpp
+#define binary_hpp
+
+#include <cstring>
+#include <bint.hpp>
+#include <ubint.hpp>
+
+#if __has_include(<span>)
+#include <span>
+#endif
+
+namespace estd
+{
+    // the order of the words of a number in a byte buffer, and of the bytes
+    // within a word. native is the byte order of the host
+    enum class endian
+    {
+        little,
+        big,
+        native
+    };
+
+    // binary import and export, for numbers laid out as words of word_size
+    // bytes: most significant word first in big order and least significant
+    // first in little order, with the bytes of each word in word_endian
+    // order. with one byte words, or with both orders the same, this is just
+    // the bytes of the number, and then the word size only pads the length
+
+    // the number of bytes export_bytes writes for a: its significant bytes,
+    // rounded up to whole words. none for zero
+    std::size_t export_size(const ubint &a, std::size_t word_size = 1);
+    // the magnitude of a, for export_bytes of a bint
+    std::size_t export_size(const bint &a, std::size_t word_size = 1);
+    // write a into the n bytes at out, with no leading zero words. returns
+    // the bytes written, export_size(a, word_size). throws if n is smaller
+    std::size_t export_bytes(const ubint &a, std::byte *out, std::size_t n, endian order = endian::big, std::size_t word_size = 1, endian word_endian = endian::native);
+    // write the magnitude of a, the sign is left to the caller. to_binary
+    // below keeps it
+    std::size_t export_bytes(const bint &a, std::byte *out, std::size_t n, endian order = endian::big, std::size_t word_size = 1, endian word_endian = endian::native);
+    // read a number from the n bytes at in. n must be a whole number of
+    // words, and leading zero words are allowed
+    ubint import_bytes(const std::byte *in, std::size_t n, endian order = endian::big, std::size_t word_size = 1, endian word_endian = endian::native);
+
+    // a compact binary format that keeps the sign: a length prefix of twice
+    // the bytes of the magnitude, plus one if the number is negative, as an
+    // unsigned little endian base 128 varint, then the magnitude least
+    // significant byte first. zero is the single byte 0 and every number has
+    // exactly one encoding, so equal numbers have equal bytes
+
+    // the bytes to_binary writes for a
+    std::size_t binary_size(const ubint &a);
+    std::size_t binary_size(const bint &a);
+    // write a into the n bytes at out in the binary format. returns the
+    // bytes written, binary_size(a). throws if n is smaller
+    std::size_t to_binary(const ubint &a, std::byte *out, std::size_t n);
+    std::size_t to_binary(const bint &a, std::byte *out, std::size_t n);
+    // read a number in the binary format from the start of the n bytes at
+    // in into a, reusing its limbs. returns the bytes it took, so numbers
+    // written one after the other read back in turn. throws if the bytes
+    // are truncated or not the one encoding of a number, or for a ubint if
+    // the number is negative
+    std::size_t from_binary(const std::byte *in, std::size_t n, ubint &a);
+    std::size_t from_binary(const std::byte *in, std::size_t n, bint &a);
+
+#if defined(__cpp_lib_span)
+    // the same on spans
+    std::size_t export_bytes(const ubint &a, std::span<std::byte> out, endian order = endian::big, std::size_t word_size = 1, endian word_endian = endian::native);
+    std::size_t export_bytes(const bint &a, std::span<std::byte> out, endian order = endian::big, std::size_t word_size = 1, endian word_endian = endian::native);
+    ubint import_bytes(std::span<const std::byte> in, endian order = endian::big, std::size_t word_size = 1, endian word_endian = endian::native);
+    std::size_t to_binary(const ubint &a, std::span<std::byte> out);
+    std::size_t to_binary(const bint &a, std::span<std::byte> out);
+    std::size_t from_binary(std::span<const std::byte> in, ubint &a);
+    std::size_t from_binary(std::span<const std::byte> in, bint &a);
+#endif
+
+    namespace detail
+    {
+        // whether bytes in the order e run least significant first
+        bool little(endian e);
+        // x with its bytes in the opposite order
+        limb_t swap_bytes(limb_t x);
+        // the significance of byte j of a buffer of words words of
+        // word_size bytes, the least significant byte of the number being 0
+        std::size_t byte_rank(std::size_t j, std::size_t words, std::size_t word_size, bool little_words, bool little_bytes);
+        // set a to the number in the n bytes at in, reusing its limbs
+        void import_bytes(ubint &a, const std::byte *in, std::size_t n, endian order, std::size_t word_size, endian word_endian);
+        // throw unless word_size is positive and n a whole number of words
+        void check_words(std::size_t n, std::size_t word_size);
+        // write h as a varint to out. returns its bytes
+        std::size_t put_varint(std::byte *out, std::uint64_t h);
+        // the bytes of h as a varint
+        std::size_t varint_size(std::uint64_t h);
+        // read the binary format of a number from the n bytes at in. sets the
+        // sign and returns the bytes taken
+        std::size_t from_binary(const std::byte *in, std::size_t n, ubint &a, bool &sign);
+        // write the binary format of the magnitude a with the sign
+        std::size_t to_binary(const ubint &a, bool sign, std::byte *out, std::size_t n);
+
+        bool little(endian e)
+        {
+            if (e == endian::native)
+            {
+            #if defined(__BYTE_ORDER__)
+                return __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+            #else
+                const std::uint16_t x = 1;
+                unsigned char c;
+                std::memcpy(&c, &x, 1);
+                return c == 1;
+            #endif
+            }
+            return e == endian::little;
+        }
+
+        limb_t swap_bytes(limb_t x)
+        {
+        #if defined(__GNUC__)
+            return sizeof(limb_t) == 8 ? (limb_t)__builtin_bswap64(x) : (limb_t)__builtin_bswap32((std::uint32_t)x);
+        #else
+            limb_t r = 0;
+            for (std::size_t b = 0; b < sizeof(limb_t); b++, x >>= 8)
+            {
+                r = r << 8 | (x & 0xff);
+            }
+            return r;
+        #endif
+        }
+
+        std::size_t byte_rank(std::size_t j, std::size_t words, std::size_t word_size, bool little_words, bool little_bytes)
+        {
+            std::size_t w = j / word_size, b = j % word_size;
+            w = little_words ? w : words - 1 - w;
+            b = little_bytes ? b : word_size - 1 - b;
+            return w * word_size + b;
+        }
+
+        void check_words(std::size_t n, std::size_t word_size)
+        {
+            if (!word_size)
+            {
+                throw std::invalid_argument("word size must be positive");
+            }
+            if (n % word_size)
+            {
+                throw std::invalid_argument("buffer must hold whole words");
+            }
+        }
+
+        void import_bytes(ubint &a, const std::byte *in, std::size_t n, endian order, std::size_t word_size, endian word_endian)
+        {
+            check_words(n, word_size);
+            const std::size_t w = sizeof(limb_t);
+            bool lw = little(order), lb = word_size == 1 ? lw : little(word_endian);
+
+            limb_vector &v = ubint_access::limbs(a);
+            v.clear();
+            v.resize((n + w - 1) / w);
+            limb_t *r = v.data();
+            if (lw == lb)
+            {
+                // one run of bytes, least or most significant first, read a
+                // whole limb at a time and swapped if the host order differs
+                std::size_t full = n / w;
+                bool swap = lw != little(endian::native);
+                for (std::size_t k = 0; k < full; k++)
+                {
+                    limb_t x;
+                    std::memcpy(&x, lw ? in + k * w : in + n - (k + 1) * w, w);
+                    r[k] = swap ? swap_bytes(x) : x;
+                }
+                for (std::size_t s = full * w; s < n; s++)
+                {
+                    std::size_t j = lw ? s : n - 1 - s;
+                    r[s / w] |= (limb_t)std::to_integer<unsigned char>(in[j]) << (8 * (s % w));
+                }
+            }
+            else
+            {
+                std::size_t words = n / word_size;
+                for (std::size_t j = 0; j < n; j++)
+                {
+                    std::size_t s = byte_rank(j, words, word_size, lw, lb);
+                    r[s / w] |= (limb_t)std::to_integer<unsigned char>(in[j]) << (8 * (s % w));
+                }
+            }
+            ubint_access::trim(a);
+        }
+
+        std::size_t varint_size(std::uint64_t h)
+        {
+            std::size_t k = 1;
+            for (; h >= 0x80; h >>= 7)
+            {
+                k++;
+            }
+
+            return k;
+        }
+
+        std::size_t put_varint(std::byte *out, std::uint64_t h)
+        {
+            std::size_t k = 0;
+            for (; h >= 0x80; h >>= 7)
+            {
+                out[k++] = std::byte((h & 0x7f) | 0x80);
+            }
+            out[k++] = std::byte(h);
+
+            return k;
+        }
+
+        std::size_t to_binary(const ubint &a, bool sign, std::byte *out, std::size_t n)
+        {
+            std::size_t len = export_size(a);
+            std::uint64_t h = (std::uint64_t)len * 2 + (sign && len);
+            std::size_t k = varint_size(h);
+            if (n < k + len)
+            {
+                throw std::length_error("buffer too small for the number");
+            }
+            k = put_varint(out, h);
+
+            return k + export_bytes(a, out + k, n - k, endian::little);
+        }
+
+        std::size_t from_binary(const std::byte *in, std::size_t n, ubint &a, bool &sign)
+        {
+            // the prefix, at most 64 bits with no redundant top group
+            std::uint64_t h = 0;
+            std::size_t k = 0;
+            for (int s = 0;; s += 7)
+            {
+                if (k == n)
+                {
+                    throw std::invalid_argument("truncated binary number");
+                }
+                std::uint64_t x = std::to_integer<std::uint64_t>(in[k++]);
+                if ((s == 63 && x > 1) || (k > 1 && !x))
+                {
+                    throw std::invalid_argument("malformed binary number");
+                }
+                h |= (x & 0x7f) << s;
+                if (!(x & 0x80))
+                {
+                    break;
+                }
+            }
+
+            std::uint64_t len = h / 2;
+            sign = h & 1;
+            if (len > n - k)
+            {
+                throw std::invalid_argument("truncated binary number");
+            }
+            // no leading zero byte, and no negative zero
+            if ((len && in[k + len - 1] == std::byte(0)) || (sign && !len))
+            {
+                throw std::invalid_argument("malformed binary number");
+            }
+            import_bytes(a, in + k, len, endian::little, 1, endian::little);
+
+            return k + len;
+        }
+    }
+
+    std::size_t export_size(const ubint &a, std::size_t word_size)
+    {
+        detail::check_words(0, word_size);
+        std::size_t bytes = (detail::bit_length(a) + 7) / 8;
+
+        return (bytes + word_size - 1) / word_size * word_size;
+    }
+
+    std::size_t export_size(const bint &a, std::size_t word_size)
+    {
+        return export_size(detail::bint_access::magnitude(a), word_size);
+    }
+
+    std::size_t export_bytes(const ubint &a, std::byte *out, std::size_t n, endian order, std::size_t word_size, endian word_endian)
+    {
+        const std::size_t w = sizeof(detail::limb_t);
+        std::size_t size = export_size(a, word_size);
+        if (n < size)
+        {
+            throw std::length_error("buffer too small for the number");
+        }
+
+        const detail::limb_vector &v = detail::ubint_access::limbs(a);
+        const detail::limb_t *x = v.data();
+        // the bytes of a, above which the words are padded with zeros
+        std::size_t bytes = (detail::bit_length(a) + 7) / 8;
+        bool lw = detail::little(order), lb = word_size == 1 ? lw : detail::little(word_endian);
+        if (lw == lb)
+        {
+            std::size_t full = bytes / w;
+            bool swap = lw != detail::little(endian::native);
+            for (std::size_t k = 0; k < full; k++)
+            {
+                detail::limb_t y = swap ? detail::swap_bytes(x[k]) : x[k];
+                std::memcpy(lw ? out + k * w : out + size - (k + 1) * w, &y, w);
+            }
+            for (std::size_t s = full * w; s < size; s++)
+            {
+                std::size_t j = lw ? s : size - 1 - s;
+                out[j] = s < bytes ? std::byte((unsigned char)(x[s / w] >> (8 * (s % w)))) : std::byte(0);
+            }
+        }
+        else
+        {
+            std::size_t words = size / word_size;
+            for (std::size_t j = 0; j < size; j++)
+            {
+                std::size_t s = detail::byte_rank(j, words, word_size, lw, lb);
+                out[j] = s < bytes ? std::byte((unsigned char)(x[s / w] >> (8 * (s % w)))) : std::byte(0);
+            }
+        }
+
+        return size;
+    }
+
+    std::size_t export_bytes(const bint &a, std::byte *out, std::size_t n, endian order, std::size_t word_size, endian word_endian)
+    {
+        return export_bytes(detail::bint_access::magnitude(a), out, n, order, word_size, word_endian);
+    }
+
+    ubint import_bytes(const std::byte *in, std::size_t n, endian order, std::size_t word_size, endian word_endian)
+    {
+        ubint r;
+        detail::import_bytes(r, in, n, order, word_size, word_endian);
+
+        return r;
+    }
+
+    std::size_t binary_size(const ubint &a)
+    {
+        std::size_t len = export_size(a);
+
+        return detail::varint_size((std::uint64_t)len * 2) + len;
+    }
+
+    std::size_t binary_size(const bint &a)
+    {
+        std::size_t len = export_size(a);
+
+        return detail::varint_size((std::uint64_t)len * 2 + detail::bint_access::sign(a)) + len;
+    }
+
+    std::size_t to_binary(const ubint &a, std::byte *out, std::size_t n)
+    {
+        return detail::to_binary(a, false, out, n);
+    }
+
+    std::size_t to_binary(const bint &a, std::byte *out, std::size_t n)
+    {
+        return detail::to_binary(detail::bint_access::magnitude(a), detail::bint_access::sign(a), out, n);
+    }
+
+    std::size_t from_binary(const std::byte *in, std::size_t n, ubint &a)
+    {
+        bool sign;
+        std::size_t k = detail::from_binary(in, n, a, sign);
+        if (sign)
+        {
+            a = 0ULL;
+            throw std::underflow_error("negative number read into a ubint");
+        }
+
+        return k;
+    }
+
+    std::size_t from_binary(const std::byte *in, std::size_t n, bint &a)
+    {
+        bool sign;
+        std::size_t k = detail::from_binary(in, n, detail::bint_access::magnitude(a), sign);
+        detail::bint_access::sign(a) = sign;
+
+        return k;
+    }
+
+#if defined(__cpp_lib_span)
+    std::size_t export_bytes(const ubint &a, std::span<std::byte> out, endian order, std::size_t word_size, endian word_endian)
+    {
+        return export_bytes(a, out.data(), out.size(), order, word_size, word_endian);
+    }
+
+    std::size_t export_bytes(const bint &a, std::span<std::byte> out, endian order, std::size_t word_size, endian word_endian)
+    {
+        return export_bytes(a, out.data(), out.size(), order, word_size, word_endian);
+    }
+
+    ubint import_bytes(std::span<const std::byte> in, endian order, std::size_t word_size, endian word_endian)
+    {
+        return import_bytes(in.data(), in.size(), order, word_size, word_endian);
+    }
+
+    std::size_t to_binary(const ubint &a, std::span<std::byte> out)
+    {
+        return to_binary(a, out.data(), out.size());
+    }
+
+    std::size_t to_binary(const bint &a, std::span<std::byte> out)
+    {
+        return to_binary(a, out.data(), out.size());
+    }
+
+    std::size_t from_binary(std::span<const std::byte> in, ubint &a)
+    {
+        return from_binary(in.data(), in.size(), a);
+    }
+
+    std::size_t from_binary(std::span<const std::byte> in, bint &a)
+    {
+        return from_binary(in.data(), in.size(), a);
+    }
+#endif
+}
+
+#endif
@@ -5,6 +5,22 @@
 
 namespace estd
 {
+    // how a signed division rounds its quotient
+    enum class rounding
+    {
+        // round towards zero, the remainder takes the sign of the dividend
+        trunc,
+        // round towards negative infinity, the remainder takes the sign of the divisor
+        floor
+    };
+
+    namespace detail
+    {
+        // direct access to the magnitude and sign of a bint, for the headers
+        // built on top of it
+        struct bint_access;
+    }
+
     // big integer
     class bint
     {
@@ -17,6 +33,8 @@ namespace estd
         // true for negative
         bool sign = false;
 
+        friend struct detail::bint_access;
+
     public:
 
         // constructors
@@ -28,6 +46,16 @@ namespace estd
         bint(const char* s);
         // copy constructor
         bint(const bint &u);
+        // move constructor, leaves u as zero
+        bint(bint &&u) noexcept;
+        // constructors allocating the magnitude from r, as for ubint
+        bint(const long long int& n, memory_resource *r);
+        bint(const std::string& s, memory_resource *r);
+        bint(const char* s, memory_resource *r);
+        bint(const bint &u, memory_resource *r);
+
+        // the resource the magnitude is allocated from
+        memory_resource *resource() const;
 
         // check if a ubint is null
         friend bool null(const bint &);
@@ -44,6 +72,9 @@ namespace estd
 
         // direct assignment
         bint &operator=(const bint &);
+        // move assignment, leaves a as zero. as for ubint, a magnitude from
+        // another resource is copied, so it may throw
+        bint &operator=(bint &&a);
 
         // post/pre incrementation
         bint &operator++();
@@ -59,8 +90,14 @@ namespace estd
         friend bint &operator+=(bint &, const bint &);
         // addition
         friend bint operator+(const bint &, const bint &);
+        // addition reusing an expiring operand
+        friend bint operator+(bint &&, const bint &);
+        friend bint operator+(const bint &, bint &&);
+        friend bint operator+(bint &&, bint &&);
         // subtraction
         friend bint operator-(const bint &, const bint &);
+        // subtraction reusing an expiring operand
+        friend bint operator-(bint &&, const bint &);
         // subtraction to self
         friend bint &operator-=(bint &, const bint &);
 
@@ -83,21 +120,56 @@ namespace estd
         friend bint &operator*=(bint &, const bint &);
         // multiply
         friend bint operator*(const bint &, const bint &);
+        // multiplication reusing an expiring operand
+        friend bint operator*(bint &&, const bint &);
+        friend bint operator*(const bint &, bint &&);
+        friend bint operator*(bint &&, bint &&);
         // divide and assign
         friend bint &operator/=(bint &, const bint &);
         // divide
         friend bint operator/(const bint &, const bint &);
+        // division reusing an expiring operand
+        friend bint operator/(bint &&, const bint &);
 
-        // modulo
+        // modulo. truncating like / and divmod, so the remainder takes the
+        // sign of a and a == (a / b) * b + a % b
         friend bint operator%(const bint &, const bint &);
+        // modulo reusing an expiring operand
+        friend bint operator%(bint &&, const bint &);
         // modulo and assign
         friend bint &operator%=(bint &, const bint &);
 
+        // quotient and remainder of a / b from a single division, so that
+        // a = q * b + r. rounds towards zero unless a mode is given
+        friend std::pair<bint, bint> divmod(const bint &a, const bint &b);
+        friend std::pair<bint, bint> divmod(const bint &a, const bint &b, rounding mode);
+        // quotient and remainder of a / b from a single division, written
+        // to q and r. q and r may be a or b
+        friend void divmod(const bint &a, const bint &b, bint &q, bint &r);
+        friend void divmod(const bint &a, const bint &b, bint &q, bint &r, rounding mode);
+
+        // fused multiply and add, as for ubint. the magnitudes are fused when
+        // the signs let them add, otherwise the product is formed first.
+        // r may be any of the operands
+        // r = a * b + c
+        friend bint &muladd(bint &r, const bint &a, const bint &b, const bint &c);
+        // r = a * b - c
+        friend bint &mulsub(bint &r, const bint &a, const bint &b, const bint &c);
+        // r += a * b
+        friend bint &addmul(bint &r, const bint &a, const bint &b);
+        // r -= a * b
+        friend bint &submul(bint &r, const bint &a, const bint &b);
+
         // bit shifts
         friend bint operator<<(const bint &, const bint &);
         friend bint &operator<<=(bint &, const bint &);
         friend bint operator>>(const bint &, const bint &);
         friend bint &operator>>=(bint &, const bint &);
+        // bit shifts by a machine word count
+        friend bint operator<<(const bint &, std::size_t);
+        friend bint &operator<<=(bint &, std::size_t);
+        friend bint operator>>(const bint &, std::size_t);
+        friend bint &operator>>=(bint &, std::size_t);
 
         // exponent
         // raise to power and assign
@@ -108,6 +180,18 @@ namespace estd
         // square root
         friend bint sqrt(const bint &);
 
+        // gcd and lcm
+        // greatest common divisor, never negative. gcd(a, 0) is |a|
+        friend bint gcd(const bint &a, const bint &b);
+        // least common multiple, never negative. zero if a or b is
+        friend bint lcm(const bint &a, const bint &b);
+        // the gcd g of a and b, setting s and t so that a s + b t = g. when
+        // a and b are non zero, |s| <= |b| / g and |t| <= |a| / g
+        friend bint xgcd(const bint &a, const bint &b, bint &s, bint &t);
+        // the x in [0, m) with a x = 1 mod m. throws if m is not positive or
+        // a has no inverse modulo m
+        friend bint invmod(const bint &a, const bint &m);
+
         // min, max
         // return the min of a and b
         friend bint min(const bint &a, const bint &b);
@@ -117,16 +201,55 @@ namespace estd
         // read and write
         // witre to output stream
         friend std::ostream &operator<<(std::ostream &, const bint &);
-        // read to input stream
+        // read to input stream, with an optional leading '-'
         friend std::istream &operator>>(std::istream &, bint &);
+        // from_chars for a bint, with an optional leading '-'
+        friend std::from_chars_result from_chars(const char *first, const char *last, bint &a);
 
-        // return n!
+        // return n!, or n (n + 1) ... (-1) for negative n
         friend bint factorial(const bint &n);
         // maps ubint x from range (a, b) to (c, d)
         friend bint map(const bint &x, const bint &a, const bint &b, const bint &c, const bint &d);
     };
 
-    bint::bint(const long long int& n)
+    namespace detail
+    {
+        struct bint_access
+        {
+            // the magnitude of a
+            static ubint &magnitude(bint &a);
+            static const ubint &magnitude(const bint &a);
+            // the sign of a, true if negative. zero must not be negative
+            static bool &sign(bint &a);
+            static bool sign(const bint &a);
+        };
+
+        ubint &bint_access::magnitude(bint &a)
+        {
+            return a.number;
+        }
+
+        const ubint &bint_access::magnitude(const bint &a)
+        {
+            return a.number;
+        }
+
+        bool &bint_access::sign(bint &a)
+        {
+            return a.sign;
+        }
+
+        bool bint_access::sign(const bint &a)
+        {
+            return a.sign;
+        }
+    }
+
+    bint::bint(const long long int& n) : bint(n, nullptr) {}
+
+    bint::bint(const std::string& s) : bint(s, nullptr) {}
+
+    bint::bint(const long long int& n, memory_resource *r) : number(0ULL, r)
     {
         if (n < 0)
         {
@@ -138,7 +261,7 @@ namespace estd
         number = n;
     }
 
-    bint::bint(const std::string& s)
+    bint::bint(const std::string& s, memory_resource *r) : number(0ULL, r)
     {
         if (s[0] == '-')
         {
@@ -152,10 +275,20 @@ namespace estd
 
     bint::bint(const char* s) : bint(std::string(s)) {}
 
-    bint::bint(const bint &u)
+    bint::bint(const char* s, memory_resource *r) : bint(std::string(s), r) {}
+
+    bint::bint(const bint &u) : number(u.number), sign(u.sign) {}
+
+    bint::bint(bint &&u) noexcept : number(std::move(u.number)), sign(u.sign)
     {
-        sign = u.sign;
-        number = u.number;
+        u.sign = false;
+    }
+
+    bint::bint(const bint &u, memory_resource *r) : number(u.number, r), sign(u.sign) {}
+
+    memory_resource *bint::resource() const
+    {
+        return number.resource();
     }
 
     std::ostream &operator<<(std::ostream &out, const bint &a)
@@ -172,14 +305,47 @@ namespace estd
 
     std::istream &operator>>(std::istream &in, bint &a)
     {
+        std::istream::sentry ok(in);
+        if (!ok)
+        {
+            return in;
+        }
+
         std::string s;
-        in >> s;
-        
-        a = (bint)s;
+        bool sign = (in.rdbuf()->sgetc() == '-');
+        if (sign)
+        {
+            in.rdbuf()->sbumpc();
+        }
+
+        detail::get_digits(in, s);
+        if (s.empty())
+        {
+            in.setstate(std::ios::failbit);
+            return in;
+        }
+
+        from_chars(s.data(), s.data() + s.size(), a.number);
+        a.sign = sign && !null(a.number);
 
         return in;
     }
 
+    std::from_chars_result from_chars(const char *first, const char *last, bint &a)
+    {
+        bool sign = (first != last && *first == '-');
+        std::from_chars_result r = from_chars(first + sign, last, a.number);
+        if (r.ec != std::errc())
+        {
+            return {first, r.ec};
+        }
+
+        // no negative zero
+        a.sign = sign && !null(a.number);
+
+        return r;
+    }
+
     bool null(const bint &a)
     {
         return null(a.number);
@@ -197,11 +363,7 @@ namespace estd
 
     int bint::operator[](const int index) const
     {
-        if (length(number) <= index || index < 0)
-        {
-            throw std::out_of_range("index out of range");
-        }
-
+        // the magnitude checks the index
         return number[index];
     }
 
@@ -221,6 +383,18 @@ namespace estd
         return (*this);
     }
 
+    bint &bint::operator=(bint &&a)
+    {
+        if (this != &a)
+        {
+            number = std::move(a.number);
+            sign = a.sign;
+            a.sign = false;
+        }
+
+        return (*this);
+    }
+
     bint &bint::operator++()
     {
         if (negative(*this))
@@ -303,31 +477,28 @@ namespace estd
     bint &operator+=(bint &a, const bint &b)
     {
         // -a + -b or a + b
-        // if a and b are posative or if a and b are negative, a + b
-        if ( (!negative(a) && !negative(b)) || (negative(a) && negative(b)))
+        // if a and b are posative or if a and b are negative, add the
+        // magnitudes and keep the sign
+        if (negative(a) == negative(b))
         {
             a.number += b.number;
             return a;
         }
 
-        // -a + b = b - a
-        // b - a
-        // if a is negative and b is posative, this is the same as
-        // b + a where b is posative and a is negative
-        // this is the same as the case below (a posative, b negative) and is used
-        // to stop repeting code
-        if (negative(a) && !negative(b))
+        // -a + b or a + -b
+        // the signs differ, so take the smaller magnitude from the larger.
+        // the result takes the sign of b if b was the larger
+        if (a.number >= b.number)
         {
-            a = b - (-a);
+            a.number -= b.number;
         }
-
-        // a + -b = a - (-b)
-        // if a is posative and b is negative
-        if (!negative(a) && negative(b))
+        else
         {
-            a = a - (-b);
+            a.number = b.number - a.number;
+            a.sign = negative(b);
         }
 
+        a.sign = a.sign && !null(a.number);
         return a;
     }
 
@@ -338,6 +509,24 @@ namespace estd
         return tmp;
     }
 
+    bint operator+(bint &&a, const bint &b)
+    {
+        a += b;
+        return std::move(a);
+    }
+
+    bint operator+(const bint &a, bint &&b)
+    {
+        b += a;
+        return std::move(b);
+    }
+
+    bint operator+(bint &&a, bint &&b)
+    {
+        a += b;
+        return std::move(a);
+    }
+
     bint operator-(const bint &a, const bint &b)
     {
         bint tmp = a;
@@ -345,52 +534,37 @@ namespace estd
         return tmp;
     }
 
-    bint &operator-=(bint &a, const bint &b)
+    bint operator-(bint &&a, const bint &b)
     {
-        // if b is negative and a is posative (a -- b = a + b)
-        // a + b
-        if (!negative(a) && negative(b))
-        {
-            a = a + -b;
-            return a;
-        }
+        a -= b;
+        return std::move(a);
+    }
 
-        // if a is negative and b is posative (-a - b)
-        // -a - b
-        // a can only get more negative
-        if (negative(a) && !negative(b))
+    bint &operator-=(bint &a, const bint &b)
+    {
+        // a - -b or -a - b
+        // if the signs differ, a moves away from zero, so add the magnitudes
+        // and keep the sign
+        if (negative(a) != negative(b))
         {
             a.number += b.number;
             return a;
         }
 
-        // if a is posative and b is posative (a - b)
-        // a - b
-        if (!negative(a) && !negative(b))
+        // a - b or -a - -b
+        // the signs match, so take the smaller magnitude from the larger.
+        // the result takes the opposite sign of b if b was the larger
+        if (a.number >= b.number)
         {
-            // if b is bigger then a, the number will be negative
-            if (b.number > a.number)
-            {
-                a.sign = true;
-                ubint reminder = b.number - a.number;
-                a.number = reminder;
-            }
-            else
-            {
-                a.number -= b.number;
-            }
-
-            return a;
+            a.number -= b.number;
         }
-
-        // if a is negative and b is negative (-a - -b = -a + b)
-        // b - a
-        if (negative(a) && negative(b))
+        else
         {
-            a = (-b) - (-a);
-            return a;
+            a.number = b.number - a.number;
+            a.sign = !negative(b);
         }
 
+        a.sign = a.sign && !null(a.number);
         return a;
     }
 
@@ -447,7 +621,7 @@ namespace estd
     bint &operator*=(bint &a, const bint &b)
     {
         a.number *= b.number;
-        a.sign = (a.sign ^ b.sign);
+        a.sign = !null(a.number) && (a.sign ^ b.sign);
 
         return a;
     }
@@ -459,10 +633,28 @@ namespace estd
         return tmp;
     }
 
+    bint operator*(bint &&a, const bint &b)
+    {
+        a *= b;
+        return std::move(a);
+    }
+
+    bint operator*(const bint &a, bint &&b)
+    {
+        b *= a;
+        return std::move(b);
+    }
+
+    bint operator*(bint &&a, bint &&b)
+    {
+        a *= b;
+        return std::move(a);
+    }
+
     bint &operator/=(bint &a, const bint &b)
     {
         a.number /= b.number;
-        a.sign = (a.sign ^ b.sign);
+        a.sign = !null(a.number) && (a.sign ^ b.sign);
 
         return a;
     }
@@ -474,6 +666,12 @@ namespace estd
         return tmp;
     }
 
+    bint operator/(bint &&a, const bint &b)
+    {
+        a /= b;
+        return std::move(a);
+    }
+
     bint operator%(const bint &a, const bint &b)
     {
         bint tmp = a;
@@ -481,14 +679,148 @@ namespace estd
         return tmp;
     }
 
+    bint operator%(bint &&a, const bint &b)
+    {
+        a %= b;
+        return std::move(a);
+    }
+
     bint &operator%=(bint &a, const bint &b)
     {
+        // the same remainder as divmod with rounding::trunc, never negative zero
         a.number %= b.number;
-        a.sign = (a.sign && b.sign) || (b.sign && !a.sign);
+        a.sign = a.sign && !null(a.number);
 
         return a;
     }
 
+    std::pair<bint, bint> divmod(const bint &a, const bint &b)
+    {
+        return divmod(a, b, rounding::trunc);
+    }
+
+    std::pair<bint, bint> divmod(const bint &a, const bint &b, rounding mode)
+    {
+        // the results come from the resource of a, as for a / b and a % b
+        std::pair<bint, bint> res(bint(0LL, a.resource()), bint(0LL, a.resource()));
+        divmod(a, b, res.first, res.second, mode);
+        return res;
+    }
+
+    void divmod(const bint &a, const bint &b, bint &q, bint &r)
+    {
+        divmod(a, b, q, r, rounding::trunc);
+    }
+
+    void divmod(const bint &a, const bint &b, bint &q, bint &r, rounding mode)
+    {
+        if (&q == &r)
+        {
+            throw std::invalid_argument("quotient and remainder must be different objects");
+        }
+
+        // |a| = Q |b| + R, then fix up the signs for the rounding mode
+        bool qsign = negative(a) != negative(b);
+        bool rsign = negative(a);
+        ubint bmag = b.number;
+        divmod(a.number, bmag, q.number, r.number);
+
+        if (mode == rounding::floor && qsign && !null(r.number))
+        {
+            // round the quotient away from zero, R becomes |b| - R
+            ++q.number;
+            r.number = bmag - r.number;
+            rsign = !rsign;
+        }
+
+        q.sign = qsign && !null(q.number);
+        r.sign = rsign && !null(r.number);
+    }
+
+    bint &muladd(bint &r, const bint &a, const bint &b, const bint &c)
+    {
+        if (null(a) || null(b))
+        {
+            r = c;
+            return r;
+        }
+
+        // if c has the sign of the product the magnitudes add
+        bool psign = negative(a) != negative(b);
+        if (null(c) || negative(c) == psign)
+        {
+            muladd(r.number, a.number, b.number, c.number);
+            r.sign = psign;
+            return r;
+        }
+
+        bint t = a * b;
+        t += c;
+        r = std::move(t);
+        return r;
+    }
+
+    bint &mulsub(bint &r, const bint &a, const bint &b, const bint &c)
+    {
+        if (null(a) || null(b))
+        {
+            r = -c;
+            return r;
+        }
+
+        // if c has the opposite sign to the product the magnitudes add
+        bool psign = negative(a) != negative(b);
+        if (null(c) || negative(c) != psign)
+        {
+            muladd(r.number, a.number, b.number, c.number);
+            r.sign = psign;
+            return r;
+        }
+
+        bint t = a * b;
+        t -= c;
+        r = std::move(t);
+        return r;
+    }
+
+    bint &addmul(bint &r, const bint &a, const bint &b)
+    {
+        if (null(a) || null(b))
+        {
+            return r;
+        }
+
+        bool psign = negative(a) != negative(b);
+        if (null(r) || negative(r) == psign)
+        {
+            addmul(r.number, a.number, b.number);
+            r.sign = psign;
+            return r;
+        }
+
+        r += a * b;
+        return r;
+    }
+
+    bint &submul(bint &r, const bint &a, const bint &b)
+    {
+        if (null(a) || null(b))
+        {
+            return r;
+        }
+
+        bool psign = negative(a) != negative(b);
+        if (null(r) || negative(r) != psign)
+        {
+            addmul(r.number, a.number, b.number);
+            r.sign = !psign;
+            return r;
+        }
+
+        r -= a * b;
+        return r;
+    }
+
     bint operator<<(const bint &a, const bint &b)
     {
         bint tmp = a;
@@ -522,6 +854,34 @@ namespace estd
         }
 
         a.number >>= b.number;
+        a.sign = a.sign && !null(a.number);
+        return a;
+    }
+
+    bint operator<<(const bint &a, std::size_t b)
+    {
+        bint tmp = a;
+        tmp <<= b;
+        return tmp;
+    }
+
+    bint &operator<<=(bint &a, std::size_t b)
+    {
+        a.number <<= b;
+        return a;
+    }
+
+    bint operator>>(const bint &a, std::size_t b)
+    {
+        bint tmp = a;
+        tmp >>= b;
+        return tmp;
+    }
+
+    bint &operator>>=(bint &a, std::size_t b)
+    {
+        a.number >>= b;
+        a.sign = a.sign && !null(a.number);
         return a;
     }
 
@@ -558,12 +918,72 @@ namespace estd
             throw std::invalid_argument("cannot squere root negative number");
         }
 
-        bint res;
+        bint res(0LL, a.resource());
         res.number = sqrt(a.number);
         res.sign = false;
         return res;
     }
 
+    bint gcd(const bint &a, const bint &b)
+    {
+        bint res(0LL, a.resource());
+        res.number = gcd(a.number, b.number);
+        return res;
+    }
+
+    bint lcm(const bint &a, const bint &b)
+    {
+        bint res;
+        res.number = lcm(a.number, b.number);
+        return res;
+    }
+
+    bint xgcd(const bint &a, const bint &b, bint &s, bint &t)
+    {
+        // g = u |a| - v |b|, or v |b| - u |a| if swapped
+        ubint u, v;
+        bool swapped;
+        bint g;
+        g.number = detail::gcdext(a.number, b.number, u, v, swapped);
+
+        s.number = std::move(u);
+        s.sign = !null(s.number) && (a.sign != swapped);
+        t.number = std::move(v);
+        t.sign = !null(t.number) && (b.sign == swapped);
+
+        return g;
+    }
+
+    bint invmod(const bint &a, const bint &m)
+    {
+        if (m.sign || null(m.number))
+        {
+            throw std::invalid_argument("modulus must be positive");
+        }
+
+        ubint r = a.number % m.number;
+        if (a.sign && !null(r))
+        {
+            r = m.number - r;
+        }
+
+        // u r = 1 + v m, or u r = -1 + v m if swapped
+        ubint u, v;
+        bool swapped;
+        if (detail::gcdext(r, m.number, u, v, swapped) != 1ULL)
+        {
+            throw std::invalid_argument("number has no inverse modulo m");
+        }
+
+        bint res;
+        res.number = (swapped && !null(u)) ? m.number - u : std::move(u);
+        if (res.number == m.number)
+        {
+            res.number = 0ULL;
+        }
+        return res;
+    }
+
     bint min(const bint &a, const bint &b)
     {
         if (a < b)
@@ -586,19 +1006,13 @@ namespace estd
 
     bint factorial(const bint &n)
     {
-        if (n.number == 1)
-        {
-            return 1;
-        }
+        // a negative n gives n (n + 1) ... (-1), which is |n|! negated when
+        // |n| is odd
+        bint tmp;
+        tmp.number = factorial(n.number);
+        tmp.sign = negative(n) && n.number % 2ULL == 1ULL;
 
-        if (negative(n))
-        {
-            return n * factorial(n + 1);
-        }
-        else
-        {
-            return n * factorial(n - 1);
-        }
+        return tmp;
     }
 
     bint map(const bint &x, const bint &a, const bint &b, const bint &c, const bint &d)
@@ -5,11 +5,17 @@
 #include <bint.hpp>
 #include <ubint.hpp>
 #include <bfloat.hpp>
+#include <expr.hpp>
+#include <fixed.hpp>
+#include <binary.hpp>
+#include <mapped.hpp>
 
 // data strucutre
+#include <batch.hpp>
 
 // random
 
 // crypto
+#include <modular.hpp>
 
 #endif
\ No newline at end of file
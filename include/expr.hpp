@@ -0,0 +1,172 @@
+#ifndef expr_hpp
+#define expr_hpp
+
+#include <bint.hpp>
+#include <ubint.hpp>
+
+namespace estd
+{
+    // optional expression templates for ubint and bint. wrapping an operand
+    // in lazy() makes * build a product instead of a value, and adding or
+    // subtracting it is matched to the fused kernels (muladd, mulsub, addmul,
+    // submul) so no temporary is made for the product:
+    //
+    //     r = lazy(a) * b + c;         // muladd
+    //     r += lazy(a) * b;            // addmul
+    //     assign(r, lazy(a) * b - c);  // mulsub, reusing the storage of r
+    //
+    // the expressions hold references to their operands, so use them within
+    // one statement and never keep one in an auto variable
+    namespace expr
+    {
+        // an operand marked for lazy evaluation
+        template <typename T>
+        struct term
+        {
+            const T &v;
+        };
+
+        // a * b
+        template <typename T>
+        struct product
+        {
+            const T &a;
+            const T &b;
+
+            // evaluate to a new value
+            operator T() const;
+        };
+
+        // a * b + c, or a * b - c if sub is set
+        template <typename T>
+        struct product_sum
+        {
+            const T &a;
+            const T &b;
+            const T &c;
+            bool sub;
+
+            // evaluate to a new value
+            operator T() const;
+        };
+
+        // mark v for lazy evaluation
+        template <typename T>
+        term<T> lazy(const T &v);
+
+        // build a product
+        template <typename T>
+        product<T> operator*(term<T> a, const T &b);
+        template <typename T>
+        product<T> operator*(const T &a, term<T> b);
+        template <typename T>
+        product<T> operator*(term<T> a, term<T> b);
+
+        // add to or subtract from a product
+        template <typename T>
+        product_sum<T> operator+(const product<T> &p, const T &c);
+        template <typename T>
+        product_sum<T> operator+(const T &c, const product<T> &p);
+        template <typename T>
+        product_sum<T> operator-(const product<T> &p, const T &c);
+
+        // accumulate a product into r
+        template <typename T>
+        T &operator+=(T &r, const product<T> &p);
+        template <typename T>
+        T &operator-=(T &r, const product<T> &p);
+
+        // evaluate an expression into r, reusing the storage r already has
+        template <typename T>
+        T &assign(T &r, const product<T> &e);
+        template <typename T>
+        T &assign(T &r, const product_sum<T> &e);
+
+        template <typename T>
+        product<T>::operator T() const
+        {
+            T r;
+            assign(r, *this);
+            return r;
+        }
+
+        template <typename T>
+        product_sum<T>::operator T() const
+        {
+            T r;
+            assign(r, *this);
+            return r;
+        }
+
+        template <typename T>
+        term<T> lazy(const T &v)
+        {
+            return term<T>{v};
+        }
+
+        template <typename T>
+        product<T> operator*(term<T> a, const T &b)
+        {
+            return product<T>{a.v, b};
+        }
+
+        template <typename T>
+        product<T> operator*(const T &a, term<T> b)
+        {
+            return product<T>{a, b.v};
+        }
+
+        template <typename T>
+        product<T> operator*(term<T> a, term<T> b)
+        {
+            return product<T>{a.v, b.v};
+        }
+
+        template <typename T>
+        product_sum<T> operator+(const product<T> &p, const T &c)
+        {
+            return product_sum<T>{p.a, p.b, c, false};
+        }
+
+        template <typename T>
+        product_sum<T> operator+(const T &c, const product<T> &p)
+        {
+            return product_sum<T>{p.a, p.b, c, false};
+        }
+
+        template <typename T>
+        product_sum<T> operator-(const product<T> &p, const T &c)
+        {
+            return product_sum<T>{p.a, p.b, c, true};
+        }
+
+        template <typename T>
+        T &operator+=(T &r, const product<T> &p)
+        {
+            return addmul(r, p.a, p.b);
+        }
+
+        template <typename T>
+        T &operator-=(T &r, const product<T> &p)
+        {
+            return submul(r, p.a, p.b);
+        }
+
+        template <typename T>
+        T &assign(T &r, const product<T> &e)
+        {
+            // a zero addend is stored inline, so this only touches r
+            return muladd(r, e.a, e.b, T());
+        }
+
+        template <typename T>
+        T &assign(T &r, const product_sum<T> &e)
+        {
+            return e.sub ? mulsub(r, e.a, e.b, e.c) : muladd(r, e.a, e.b, e.c);
+        }
+    }
+
+    using expr::lazy;
+}
+
+#endif
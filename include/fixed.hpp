@@ -0,0 +1,1318 @@
+#ifndef fixed_hpp
+#define fixed_hpp
+
+#include <array>
+#include <bint.hpp>
+#include <ubint.hpp>
+
+namespace estd
+{
+    // unsigned integer of exactly Bits bits, a multiple of the limb size,
+    // with its limbs in a std::array so it never allocates. arithmetic wraps
+    // modulo 2^Bits like the built in unsigned types and is constexpr, with
+    // the loops over the limbs unrolled at compile time. add_overflow and the
+    // others report a result that does not fit, and checked_add and the
+    // others throw on one
+    template <std::size_t Bits>
+    class fixed_uint;
+    // signed integer of exactly Bits bits in two's complement, with the same
+    // storage and the same wrapping arithmetic as fixed_uint
+    template <std::size_t Bits>
+    class fixed_int;
+
+    namespace detail
+    {
+        // the limbs of a fixed width number, least significant first
+        template <std::size_t N>
+        using fixed_limbs = std::array<limb_t, N>;
+
+        // numbers of at most this many limbs get fully unrolled kernels,
+        // longer ones loops, which keeps the code of wide types in check
+        const std::size_t fixed_unroll = 16;
+
+        // f(i) for i = 0 .. N - 1 in order, with i a std::integral_constant
+        // when unrolled and a std::size_t otherwise
+        template <std::size_t N, typename F>
+        constexpr void unroll(F &&f);
+        template <typename F, std::size_t... I>
+        constexpr void unroll(F &&f, std::index_sequence<I...>);
+
+        // number of leading zero bits in a non zero limb, in a constant expression
+        constexpr int fixed_clz(limb_t x);
+        // whether a is zero
+        template <std::size_t N>
+        constexpr bool fixed_zero(const fixed_limbs<N> &a);
+        // compare a and b. returns -1, 0 or 1
+        template <std::size_t N>
+        constexpr int fixed_cmp(const fixed_limbs<N> &a, const fixed_limbs<N> &b);
+        // r = a + b. returns the carry
+        template <std::size_t N>
+        constexpr limb_t fixed_add(fixed_limbs<N> &r, const fixed_limbs<N> &a, const fixed_limbs<N> &b);
+        // r = a - b. returns the borrow
+        template <std::size_t N>
+        constexpr limb_t fixed_sub(fixed_limbs<N> &r, const fixed_limbs<N> &a, const fixed_limbs<N> &b);
+        // r = -a mod B^N
+        template <std::size_t N>
+        constexpr void fixed_neg(fixed_limbs<N> &r, const fixed_limbs<N> &a);
+        // r = a * b mod B^N, forming only the products below B^N. returns
+        // whether the full product is B^N or more
+        template <std::size_t N>
+        constexpr bool fixed_mul(fixed_limbs<N> &r, const fixed_limbs<N> &a, const fixed_limbs<N> &b);
+        // r = a << s mod B^N, for s below N limb_bits
+        template <std::size_t N>
+        constexpr void fixed_shl(fixed_limbs<N> &r, const fixed_limbs<N> &a, std::size_t s);
+        // r = a >> s, for s below N limb_bits, shifting in the limb fill
+        // from the top (zero, or all ones for a negative two's complement a)
+        template <std::size_t N>
+        constexpr void fixed_shr(fixed_limbs<N> &r, const fixed_limbs<N> &a, std::size_t s, limb_t fill);
+        // q = a / b and r = a % b for a non zero b, by knuth's algorithm d.
+        // q and r may be a or b
+        template <std::size_t N>
+        constexpr void fixed_divrem(fixed_limbs<N> &q, fixed_limbs<N> &r, const fixed_limbs<N> &a, const fixed_limbs<N> &b);
+
+        template <std::size_t N, typename F>
+        constexpr void unroll(F &&f)
+        {
+            if constexpr (N <= fixed_unroll)
+            {
+                unroll(f, std::make_index_sequence<N>());
+            }
+            else
+            {
+                for (std::size_t i = 0; i < N; i++)
+                {
+                    f(i);
+                }
+            }
+        }
+
+        template <typename F, std::size_t... I>
+        constexpr void unroll(F &&f, std::index_sequence<I...>)
+        {
+            (f(std::integral_constant<std::size_t, I>()), ...);
+        }
+
+        constexpr int fixed_clz(limb_t x)
+        {
+            int n = 0;
+            for (int s = limb_bits / 2; s; s /= 2)
+            {
+                if (!(x >> (limb_bits - s)))
+                {
+                    x <<= s;
+                    n += s;
+                }
+            }
+            return n;
+        }
+
+        template <std::size_t N>
+        constexpr bool fixed_zero(const fixed_limbs<N> &a)
+        {
+            limb_t x = 0;
+            unroll<N>([&](auto i)
+            {
+                x |= a[i];
+            });
+            return !x;
+        }
+
+        template <std::size_t N>
+        constexpr int fixed_cmp(const fixed_limbs<N> &a, const fixed_limbs<N> &b)
+        {
+            // from the top limb down, the first difference decides
+            int c = 0;
+            unroll<N>([&](auto i)
+            {
+                std::size_t k = N - 1 - i;
+                if (!c && a[k] != b[k])
+                {
+                    c = a[k] < b[k] ? -1 : 1;
+                }
+            });
+            return c;
+        }
+
+        template <std::size_t N>
+        constexpr limb_t fixed_add(fixed_limbs<N> &r, const fixed_limbs<N> &a, const fixed_limbs<N> &b)
+        {
+            limb_t c = 0;
+            unroll<N>([&](auto i)
+            {
+                limb_t s = a[i] + c;
+                c = s < c;
+                limb_t t = s + b[i];
+                c += t < s;
+                r[i] = t;
+            });
+            return c;
+        }
+
+        template <std::size_t N>
+        constexpr limb_t fixed_sub(fixed_limbs<N> &r, const fixed_limbs<N> &a, const fixed_limbs<N> &b)
+        {
+            limb_t c = 0;
+            unroll<N>([&](auto i)
+            {
+                limb_t t = a[i] - b[i];
+                limb_t borrow = a[i] < b[i];
+                limb_t u = t - c;
+                c = borrow | (t < c);
+                r[i] = u;
+            });
+            return c;
+        }
+
+        template <std::size_t N>
+        constexpr void fixed_neg(fixed_limbs<N> &r, const fixed_limbs<N> &a)
+        {
+            fixed_sub(r, fixed_limbs<N>{}, a);
+        }
+
+        template <std::size_t N>
+        constexpr bool fixed_mul(fixed_limbs<N> &r, const fixed_limbs<N> &a, const fixed_limbs<N> &b)
+        {
+            // the product is built in t, as r may be a or b
+            fixed_limbs<N> t = {};
+            bool over = false;
+            unroll<N>([&](auto i)
+            {
+                limb_t c = 0;
+                unroll<N>([&](auto j)
+                {
+                    if (i + j < N)
+                    {
+                        dlimb_t p = (dlimb_t)a[i] * b[j] + t[i + j] + c;
+                        t[i + j] = (limb_t)p;
+                        c = (limb_t)(p >> limb_bits);
+                    }
+                    else if (a[i] && b[j])
+                    {
+                        over = true;
+                    }
+                });
+                // the carry out of the row lands at B^N
+                over = over || c;
+            });
+            r = t;
+            return over;
+        }
+
+        template <std::size_t N>
+        constexpr void fixed_shl(fixed_limbs<N> &r, const fixed_limbs<N> &a, std::size_t s)
+        {
+            std::size_t k = s / limb_bits;
+            int b = s % limb_bits;
+            fixed_limbs<N> t = {};
+            for (std::size_t i = k; i < N; i++)
+            {
+                t[i] = a[i - k] << b;
+                if (b && i > k)
+                {
+                    t[i] |= a[i - k - 1] >> (limb_bits - b);
+                }
+            }
+            r = t;
+        }
+
+        template <std::size_t N>
+        constexpr void fixed_shr(fixed_limbs<N> &r, const fixed_limbs<N> &a, std::size_t s, limb_t fill)
+        {
+            std::size_t k = s / limb_bits;
+            int b = s % limb_bits;
+            fixed_limbs<N> t = {};
+            for (std::size_t i = 0; i < N; i++)
+            {
+                limb_t lo = i + k < N ? a[i + k] : fill;
+                limb_t hi = i + k + 1 < N ? a[i + k + 1] : fill;
+                t[i] = b ? (lo >> b | hi << (limb_bits - b)) : lo;
+            }
+            r = t;
+        }
+
+        template <std::size_t N>
+        constexpr void fixed_divrem(fixed_limbs<N> &q, fixed_limbs<N> &r, const fixed_limbs<N> &a, const fixed_limbs<N> &b)
+        {
+            std::size_t n = N, m = N;
+            while (n && !a[n - 1])
+            {
+                n--;
+            }
+            while (!b[m - 1])
+            {
+                m--;
+            }
+
+            // written to q and r at the end, as they may be a or b
+            fixed_limbs<N> x = {}, y = {};
+            if (n < m)
+            {
+                y = a;
+            }
+            else if (m == 1)
+            {
+                dlimb_t rem = 0;
+                for (std::size_t i = n; i-- > 0;)
+                {
+                    dlimb_t cur = rem << limb_bits | a[i];
+                    x[i] = (limb_t)(cur / b[0]);
+                    rem = cur % b[0];
+                }
+                y[0] = (limb_t)rem;
+            }
+            else if constexpr (N > 1)
+            {
+                // shift both so the top limb of the divisor has its top bit
+                // set, which keeps each estimated quotient limb at most two
+                // above the true one
+                int s = fixed_clz(b[m - 1]);
+                limb_t d[N] = {}, u[N + 1] = {};
+                for (std::size_t i = 0; i < m; i++)
+                {
+                    d[i] = b[i] << s | ((s && i) ? b[i - 1] >> (limb_bits - s) : 0);
+                }
+                for (std::size_t i = 0; i < n; i++)
+                {
+                    u[i] = a[i] << s | ((s && i) ? a[i - 1] >> (limb_bits - s) : 0);
+                }
+                u[n] = s ? a[n - 1] >> (limb_bits - s) : 0;
+
+                for (std::size_t j = n - m + 1; j-- > 0;)
+                {
+                    dlimb_t num = (dlimb_t)u[j + m] << limb_bits | u[j + m - 1];
+                    dlimb_t qh = num / d[m - 1], rh = num % d[m - 1];
+                    while ((qh >> limb_bits) || qh * d[m - 2] > (rh << limb_bits | u[j + m - 2]))
+                    {
+                        qh--;
+                        rh += d[m - 1];
+                        if (rh >> limb_bits)
+                        {
+                            break;
+                        }
+                    }
+
+                    // u -= qh d, adding d back if qh was still one too large
+                    limb_t carry = 0, borrow = 0;
+                    for (std::size_t i = 0; i < m; i++)
+                    {
+                        dlimb_t p = qh * d[i] + carry;
+                        carry = (limb_t)(p >> limb_bits);
+                        limb_t lo = (limb_t)p;
+                        limb_t t = u[i + j] - lo;
+                        limb_t under = u[i + j] < lo;
+                        u[i + j] = t - borrow;
+                        borrow = under | (t < borrow);
+                    }
+                    limb_t t = u[j + m] - carry;
+                    limb_t under = u[j + m] < carry;
+                    u[j + m] = t - borrow;
+                    borrow = under | (t < borrow);
+
+                    if (borrow)
+                    {
+                        qh--;
+                        limb_t c = 0;
+                        for (std::size_t i = 0; i < m; i++)
+                        {
+                            dlimb_t sum = (dlimb_t)u[i + j] + d[i] + c;
+                            u[i + j] = (limb_t)sum;
+                            c = (limb_t)(sum >> limb_bits);
+                        }
+                        u[j + m] += c;
+                    }
+                    x[j] = (limb_t)qh;
+                }
+
+                for (std::size_t i = 0; i < m; i++)
+                {
+                    y[i] = u[i] >> s | (s ? u[i + 1] << (limb_bits - s) : 0);
+                }
+            }
+
+            q = x;
+            r = y;
+        }
+    }
+
+    template <std::size_t Bits>
+    class fixed_uint
+    {
+        static_assert(Bits > 0 && Bits % detail::limb_bits == 0, "the width of a fixed_uint must be a positive multiple of the limb size");
+
+    public:
+        // the width in bits and in limbs
+        static constexpr std::size_t bits = Bits;
+        static constexpr std::size_t limb_count = Bits / detail::limb_bits;
+
+        // constructors
+        // int constructor
+        constexpr fixed_uint(unsigned long long n = 0);
+        // a fixed_uint of another width, truncated or zero extended
+        template <std::size_t B>
+        explicit constexpr fixed_uint(const fixed_uint<B> &a);
+        // the bits of a, read as unsigned
+        explicit constexpr fixed_uint(const fixed_int<Bits> &a);
+        // ubint constructor, throws if a does not fit
+        explicit fixed_uint(const ubint &a);
+
+        // the largest value, 2^Bits - 1
+        static constexpr fixed_uint max();
+
+        // conversions
+        explicit operator ubint() const;
+        explicit constexpr operator bool() const;
+
+        // member access
+        // the limbs, least significant first
+        constexpr const detail::fixed_limbs<limb_count> &limbs() const;
+        constexpr detail::fixed_limbs<limb_count> &limbs();
+
+        // arithmetic, modulo 2^Bits
+        constexpr fixed_uint &operator+=(const fixed_uint &a);
+        constexpr fixed_uint &operator-=(const fixed_uint &a);
+        constexpr fixed_uint &operator*=(const fixed_uint &a);
+        // division and remainder, throw if a is zero
+        constexpr fixed_uint &operator/=(const fixed_uint &a);
+        constexpr fixed_uint &operator%=(const fixed_uint &a);
+        // raise to power, as ^ does for ubint
+        constexpr fixed_uint &operator^=(const fixed_uint &a);
+        constexpr fixed_uint &operator++();
+        constexpr fixed_uint operator++(int);
+        constexpr fixed_uint &operator--();
+        constexpr fixed_uint operator--(int);
+
+        // bitwise operations. shifting by Bits or more gives zero. ^ is a
+        // power as for ubint, the exclusive or is bitwise_xor
+        constexpr fixed_uint &operator&=(const fixed_uint &a);
+        constexpr fixed_uint &operator|=(const fixed_uint &a);
+        constexpr fixed_uint &operator<<=(std::size_t s);
+        constexpr fixed_uint &operator>>=(std::size_t s);
+
+        friend constexpr fixed_uint operator+(fixed_uint a, const fixed_uint &b)
+        {
+            return a += b;
+        }
+
+        friend constexpr fixed_uint operator-(fixed_uint a, const fixed_uint &b)
+        {
+            return a -= b;
+        }
+
+        friend constexpr fixed_uint operator*(fixed_uint a, const fixed_uint &b)
+        {
+            return a *= b;
+        }
+
+        friend constexpr fixed_uint operator/(fixed_uint a, const fixed_uint &b)
+        {
+            return a /= b;
+        }
+
+        friend constexpr fixed_uint operator%(fixed_uint a, const fixed_uint &b)
+        {
+            return a %= b;
+        }
+
+        friend constexpr fixed_uint operator-(const fixed_uint &a)
+        {
+            fixed_uint r;
+            detail::fixed_neg(r.w, a.w);
+            return r;
+        }
+
+        friend constexpr fixed_uint operator&(fixed_uint a, const fixed_uint &b)
+        {
+            return a &= b;
+        }
+
+        friend constexpr fixed_uint operator|(fixed_uint a, const fixed_uint &b)
+        {
+            return a |= b;
+        }
+
+        friend constexpr fixed_uint operator^(fixed_uint a, const fixed_uint &b)
+        {
+            return a ^= b;
+        }
+
+        friend constexpr fixed_uint bitwise_xor(fixed_uint a, const fixed_uint &b)
+        {
+            detail::unroll<limb_count>([&](auto i)
+            {
+                a.w[i] ^= b.w[i];
+            });
+            return a;
+        }
+
+        friend constexpr fixed_uint operator~(fixed_uint a)
+        {
+            detail::unroll<limb_count>([&](auto i)
+            {
+                a.w[i] = ~a.w[i];
+            });
+            return a;
+        }
+
+        friend constexpr fixed_uint operator<<(fixed_uint a, std::size_t s)
+        {
+            return a <<= s;
+        }
+
+        friend constexpr fixed_uint operator>>(fixed_uint a, std::size_t s)
+        {
+            return a >>= s;
+        }
+
+        // comparison
+        friend constexpr bool operator==(const fixed_uint &a, const fixed_uint &b)
+        {
+            return detail::fixed_cmp(a.w, b.w) == 0;
+        }
+
+        friend constexpr bool operator!=(const fixed_uint &a, const fixed_uint &b)
+        {
+            return detail::fixed_cmp(a.w, b.w) != 0;
+        }
+
+        friend constexpr bool operator<(const fixed_uint &a, const fixed_uint &b)
+        {
+            return detail::fixed_cmp(a.w, b.w) < 0;
+        }
+
+        friend constexpr bool operator<=(const fixed_uint &a, const fixed_uint &b)
+        {
+            return detail::fixed_cmp(a.w, b.w) <= 0;
+        }
+
+        friend constexpr bool operator>(const fixed_uint &a, const fixed_uint &b)
+        {
+            return detail::fixed_cmp(a.w, b.w) > 0;
+        }
+
+        friend constexpr bool operator>=(const fixed_uint &a, const fixed_uint &b)
+        {
+            return detail::fixed_cmp(a.w, b.w) >= 0;
+        }
+
+        // write to output stream, in decimal
+        friend std::ostream &operator<<(std::ostream &out, const fixed_uint &a)
+        {
+            return out << ubint(a);
+        }
+
+    private:
+        detail::fixed_limbs<limb_count> w;
+    };
+
+    template <std::size_t Bits>
+    class fixed_int
+    {
+        static_assert(Bits > 0 && Bits % detail::limb_bits == 0, "the width of a fixed_int must be a positive multiple of the limb size");
+
+    public:
+        // the width in bits and in limbs
+        static constexpr std::size_t bits = Bits;
+        static constexpr std::size_t limb_count = Bits / detail::limb_bits;
+
+        // constructors
+        // int constructor
+        constexpr fixed_int(long long n = 0);
+        // a fixed_int of another width, truncated or sign extended
+        template <std::size_t B>
+        explicit constexpr fixed_int(const fixed_int<B> &a);
+        // the bits of a, read as two's complement
+        explicit constexpr fixed_int(const fixed_uint<Bits> &a);
+        // bint constructor, throws if a does not fit
+        explicit fixed_int(const bint &a);
+
+        // the smallest value, -2^(Bits - 1), and the largest, 2^(Bits - 1) - 1
+        static constexpr fixed_int min();
+        static constexpr fixed_int max();
+
+        // conversions
+        explicit operator bint() const;
+        explicit constexpr operator bool() const;
+
+        // member access
+        // the limbs of the two's complement form, least significant first
+        constexpr const detail::fixed_limbs<limb_count> &limbs() const;
+        constexpr detail::fixed_limbs<limb_count> &limbs();
+
+        // arithmetic, modulo 2^Bits
+        constexpr fixed_int &operator+=(const fixed_int &a);
+        constexpr fixed_int &operator-=(const fixed_int &a);
+        constexpr fixed_int &operator*=(const fixed_int &a);
+        // division rounds towards zero and the remainder takes the sign of
+        // the dividend, as for the built in types. min() / -1 wraps to min().
+        // both throw if a is zero
+        constexpr fixed_int &operator/=(const fixed_int &a);
+        constexpr fixed_int &operator%=(const fixed_int &a);
+        // raise to power, as ^ does for bint. throws if a is negative
+        constexpr fixed_int &operator^=(const fixed_int &a);
+        constexpr fixed_int &operator++();
+        constexpr fixed_int operator++(int);
+        constexpr fixed_int &operator--();
+        constexpr fixed_int operator--(int);
+
+        // bitwise operations on the two's complement form. >> is arithmetic,
+        // and shifting by Bits or more gives zero or -1. ^ is a power as for
+        // bint, the exclusive or is bitwise_xor
+        constexpr fixed_int &operator&=(const fixed_int &a);
+        constexpr fixed_int &operator|=(const fixed_int &a);
+        constexpr fixed_int &operator<<=(std::size_t s);
+        constexpr fixed_int &operator>>=(std::size_t s);
+
+        // check if a is negative
+        friend constexpr bool negative(const fixed_int &a)
+        {
+            return a.w[limb_count - 1] >> (detail::limb_bits - 1);
+        }
+
+        friend constexpr fixed_int operator+(fixed_int a, const fixed_int &b)
+        {
+            return a += b;
+        }
+
+        friend constexpr fixed_int operator-(fixed_int a, const fixed_int &b)
+        {
+            return a -= b;
+        }
+
+        friend constexpr fixed_int operator*(fixed_int a, const fixed_int &b)
+        {
+            return a *= b;
+        }
+
+        friend constexpr fixed_int operator/(fixed_int a, const fixed_int &b)
+        {
+            return a /= b;
+        }
+
+        friend constexpr fixed_int operator%(fixed_int a, const fixed_int &b)
+        {
+            return a %= b;
+        }
+
+        friend constexpr fixed_int operator-(const fixed_int &a)
+        {
+            fixed_int r;
+            detail::fixed_neg(r.w, a.w);
+            return r;
+        }
+
+        friend constexpr fixed_int operator&(fixed_int a, const fixed_int &b)
+        {
+            return a &= b;
+        }
+
+        friend constexpr fixed_int operator|(fixed_int a, const fixed_int &b)
+        {
+            return a |= b;
+        }
+
+        friend constexpr fixed_int operator^(fixed_int a, const fixed_int &b)
+        {
+            return a ^= b;
+        }
+
+        friend constexpr fixed_int bitwise_xor(fixed_int a, const fixed_int &b)
+        {
+            detail::unroll<limb_count>([&](auto i)
+            {
+                a.w[i] ^= b.w[i];
+            });
+            return a;
+        }
+
+        friend constexpr fixed_int operator~(fixed_int a)
+        {
+            detail::unroll<limb_count>([&](auto i)
+            {
+                a.w[i] = ~a.w[i];
+            });
+            return a;
+        }
+
+        friend constexpr fixed_int operator<<(fixed_int a, std::size_t s)
+        {
+            return a <<= s;
+        }
+
+        friend constexpr fixed_int operator>>(fixed_int a, std::size_t s)
+        {
+            return a >>= s;
+        }
+
+        // comparison
+        friend constexpr bool operator==(const fixed_int &a, const fixed_int &b)
+        {
+            return detail::fixed_cmp(a.w, b.w) == 0;
+        }
+
+        friend constexpr bool operator!=(const fixed_int &a, const fixed_int &b)
+        {
+            return detail::fixed_cmp(a.w, b.w) != 0;
+        }
+
+        friend constexpr bool operator<(const fixed_int &a, const fixed_int &b)
+        {
+            return fixed_int::cmp(a, b) < 0;
+        }
+
+        friend constexpr bool operator<=(const fixed_int &a, const fixed_int &b)
+        {
+            return fixed_int::cmp(a, b) <= 0;
+        }
+
+        friend constexpr bool operator>(const fixed_int &a, const fixed_int &b)
+        {
+            return fixed_int::cmp(a, b) > 0;
+        }
+
+        friend constexpr bool operator>=(const fixed_int &a, const fixed_int &b)
+        {
+            return fixed_int::cmp(a, b) >= 0;
+        }
+
+        // write to output stream, in decimal
+        friend std::ostream &operator<<(std::ostream &out, const fixed_int &a)
+        {
+            return out << bint(a);
+        }
+
+    private:
+        detail::fixed_limbs<limb_count> w;
+
+        // signed comparison of a and b. returns -1, 0 or 1
+        static constexpr int cmp(const fixed_int &a, const fixed_int &b);
+    };
+
+    // the overflow checks. each writes the wrapped result to r, as the
+    // arithmetic operators would, and returns true if the exact result does
+    // not fit
+    template <std::size_t Bits>
+    constexpr bool add_overflow(const fixed_uint<Bits> &a, const fixed_uint<Bits> &b, fixed_uint<Bits> &r);
+    template <std::size_t Bits>
+    constexpr bool sub_overflow(const fixed_uint<Bits> &a, const fixed_uint<Bits> &b, fixed_uint<Bits> &r);
+    template <std::size_t Bits>
+    constexpr bool mul_overflow(const fixed_uint<Bits> &a, const fixed_uint<Bits> &b, fixed_uint<Bits> &r);
+    template <std::size_t Bits>
+    constexpr bool add_overflow(const fixed_int<Bits> &a, const fixed_int<Bits> &b, fixed_int<Bits> &r);
+    template <std::size_t Bits>
+    constexpr bool sub_overflow(const fixed_int<Bits> &a, const fixed_int<Bits> &b, fixed_int<Bits> &r);
+    template <std::size_t Bits>
+    constexpr bool mul_overflow(const fixed_int<Bits> &a, const fixed_int<Bits> &b, fixed_int<Bits> &r);
+
+    // the checked operations. each returns the exact result, and throws
+    // std::overflow_error if it does not fit (std::underflow_error for an
+    // unsigned subtraction going below zero, as for ubint)
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits> checked_add(const fixed_uint<Bits> &a, const fixed_uint<Bits> &b);
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits> checked_sub(const fixed_uint<Bits> &a, const fixed_uint<Bits> &b);
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits> checked_mul(const fixed_uint<Bits> &a, const fixed_uint<Bits> &b);
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> checked_add(const fixed_int<Bits> &a, const fixed_int<Bits> &b);
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> checked_sub(const fixed_int<Bits> &a, const fixed_int<Bits> &b);
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> checked_mul(const fixed_int<Bits> &a, const fixed_int<Bits> &b);
+
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits>::fixed_uint(unsigned long long n) : w{}
+    {
+        // a limb may be narrower than n
+        for (std::size_t i = 0; i < limb_count && n; i++)
+        {
+            w[i] = (detail::limb_t)n;
+            n = (n >> (detail::limb_bits - 1)) >> 1;
+        }
+    }
+
+    template <std::size_t Bits>
+    template <std::size_t B>
+    constexpr fixed_uint<Bits>::fixed_uint(const fixed_uint<B> &a) : w{}
+    {
+        for (std::size_t i = 0; i < limb_count && i < a.limb_count; i++)
+        {
+            w[i] = a.limbs()[i];
+        }
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits>::fixed_uint(const fixed_int<Bits> &a) : w(a.limbs()) {}
+
+    template <std::size_t Bits>
+    fixed_uint<Bits>::fixed_uint(const ubint &a) : w{}
+    {
+        const detail::limb_vector &x = detail::ubint_access::limbs(a);
+        if (x.size() > limb_count)
+        {
+            throw std::overflow_error("number too large for the fixed width");
+        }
+        std::copy(x.data(), x.data() + x.size(), w.begin());
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits> fixed_uint<Bits>::max()
+    {
+        return ~fixed_uint();
+    }
+
+    template <std::size_t Bits>
+    fixed_uint<Bits>::operator ubint() const
+    {
+        ubint r;
+        detail::ubint_access::limbs(r).assign(w.data(), limb_count);
+        detail::ubint_access::trim(r);
+        return r;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits>::operator bool() const
+    {
+        return !detail::fixed_zero(w);
+    }
+
+    template <std::size_t Bits>
+    constexpr const detail::fixed_limbs<fixed_uint<Bits>::limb_count> &fixed_uint<Bits>::limbs() const
+    {
+        return w;
+    }
+
+    template <std::size_t Bits>
+    constexpr detail::fixed_limbs<fixed_uint<Bits>::limb_count> &fixed_uint<Bits>::limbs()
+    {
+        return w;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits> &fixed_uint<Bits>::operator+=(const fixed_uint &a)
+    {
+        detail::fixed_add(w, w, a.w);
+        return *this;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits> &fixed_uint<Bits>::operator-=(const fixed_uint &a)
+    {
+        detail::fixed_sub(w, w, a.w);
+        return *this;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits> &fixed_uint<Bits>::operator*=(const fixed_uint &a)
+    {
+        detail::fixed_mul(w, w, a.w);
+        return *this;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits> &fixed_uint<Bits>::operator/=(const fixed_uint &a)
+    {
+        if (detail::fixed_zero(a.w))
+        {
+            throw std::invalid_argument("cannot divide by zero");
+        }
+
+        detail::fixed_limbs<limb_count> r = {};
+        detail::fixed_divrem(w, r, w, a.w);
+        return *this;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits> &fixed_uint<Bits>::operator%=(const fixed_uint &a)
+    {
+        if (detail::fixed_zero(a.w))
+        {
+            throw std::invalid_argument("cannot divide by zero");
+        }
+
+        detail::fixed_limbs<limb_count> q = {};
+        detail::fixed_divrem(q, w, w, a.w);
+        return *this;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits> &fixed_uint<Bits>::operator++()
+    {
+        return *this += fixed_uint(1);
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits> fixed_uint<Bits>::operator++(int)
+    {
+        fixed_uint r = *this;
+        ++*this;
+        return r;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits> &fixed_uint<Bits>::operator--()
+    {
+        return *this -= fixed_uint(1);
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits> fixed_uint<Bits>::operator--(int)
+    {
+        fixed_uint r = *this;
+        --*this;
+        return r;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits> &fixed_uint<Bits>::operator&=(const fixed_uint &a)
+    {
+        detail::unroll<limb_count>([&](auto i)
+        {
+            w[i] &= a.w[i];
+        });
+        return *this;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits> &fixed_uint<Bits>::operator|=(const fixed_uint &a)
+    {
+        detail::unroll<limb_count>([&](auto i)
+        {
+            w[i] |= a.w[i];
+        });
+        return *this;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits> &fixed_uint<Bits>::operator^=(const fixed_uint &a)
+    {
+        // square and multiply from the low bit of the exponent, which is
+        // copied first as a may be this
+        fixed_uint base = *this, e = a;
+        *this = 1;
+        while (!detail::fixed_zero(e.w))
+        {
+            if (e.w[0] & 1)
+            {
+                *this *= base;
+            }
+            base *= base;
+            e >>= 1;
+        }
+        return *this;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits> &fixed_uint<Bits>::operator<<=(std::size_t s)
+    {
+        if (s >= Bits)
+        {
+            w = {};
+        }
+        else
+        {
+            detail::fixed_shl(w, w, s);
+        }
+        return *this;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits> &fixed_uint<Bits>::operator>>=(std::size_t s)
+    {
+        if (s >= Bits)
+        {
+            w = {};
+        }
+        else
+        {
+            detail::fixed_shr(w, w, s, 0);
+        }
+        return *this;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits>::fixed_int(long long n) : w{}
+    {
+        // the two's complement form of n, sign extended through the limbs
+        // above it
+        unsigned long long x = n;
+        detail::limb_t fill = n < 0 ? ~detail::limb_t(0) : 0;
+        for (std::size_t i = 0; i < limb_count; i++)
+        {
+            w[i] = i * detail::limb_bits < 64 ? (detail::limb_t)(x >> (i * detail::limb_bits)) : fill;
+        }
+    }
+
+    template <std::size_t Bits>
+    template <std::size_t B>
+    constexpr fixed_int<Bits>::fixed_int(const fixed_int<B> &a) : w{}
+    {
+        detail::limb_t fill = negative(a) ? ~detail::limb_t(0) : 0;
+        for (std::size_t i = 0; i < limb_count; i++)
+        {
+            w[i] = i < a.limb_count ? a.limbs()[i] : fill;
+        }
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits>::fixed_int(const fixed_uint<Bits> &a) : w(a.limbs()) {}
+
+    template <std::size_t Bits>
+    fixed_int<Bits>::fixed_int(const bint &a) : w{}
+    {
+        // the magnitude must be below 2^(Bits - 1), or equal to it for a
+        // negative a
+        const detail::limb_vector &x = detail::ubint_access::limbs(detail::bint_access::magnitude(a));
+        bool neg = detail::bint_access::sign(a);
+        if (x.size() > limb_count)
+        {
+            throw std::overflow_error("number too large for the fixed width");
+        }
+        std::copy(x.data(), x.data() + x.size(), w.begin());
+
+        bool top = negative(*this);
+        w[limb_count - 1] &= ~detail::limb_t(0) >> 1;
+        if (top && (!neg || !detail::fixed_zero(w)))
+        {
+            throw std::overflow_error("number too large for the fixed width");
+        }
+        if (top)
+        {
+            w[limb_count - 1] |= ~(~detail::limb_t(0) >> 1);
+        }
+
+        if (neg)
+        {
+            detail::fixed_neg(w, w);
+        }
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> fixed_int<Bits>::min()
+    {
+        fixed_int r;
+        r.w[limb_count - 1] = ~(~detail::limb_t(0) >> 1);
+        return r;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> fixed_int<Bits>::max()
+    {
+        return ~min();
+    }
+
+    template <std::size_t Bits>
+    fixed_int<Bits>::operator bint() const
+    {
+        bint r;
+        fixed_uint<Bits> m(negative(*this) ? -*this : *this);
+        detail::bint_access::magnitude(r) = ubint(m);
+        detail::bint_access::sign(r) = negative(*this);
+        return r;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits>::operator bool() const
+    {
+        return !detail::fixed_zero(w);
+    }
+
+    template <std::size_t Bits>
+    constexpr const detail::fixed_limbs<fixed_int<Bits>::limb_count> &fixed_int<Bits>::limbs() const
+    {
+        return w;
+    }
+
+    template <std::size_t Bits>
+    constexpr detail::fixed_limbs<fixed_int<Bits>::limb_count> &fixed_int<Bits>::limbs()
+    {
+        return w;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> &fixed_int<Bits>::operator+=(const fixed_int &a)
+    {
+        detail::fixed_add(w, w, a.w);
+        return *this;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> &fixed_int<Bits>::operator-=(const fixed_int &a)
+    {
+        detail::fixed_sub(w, w, a.w);
+        return *this;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> &fixed_int<Bits>::operator*=(const fixed_int &a)
+    {
+        // the low Bits bits of a two's complement product do not depend on
+        // the signs
+        detail::fixed_mul(w, w, a.w);
+        return *this;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> &fixed_int<Bits>::operator/=(const fixed_int &a)
+    {
+        if (detail::fixed_zero(a.w))
+        {
+            throw std::invalid_argument("cannot divide by zero");
+        }
+
+        // divide the magnitudes. that of min() is 2^(Bits - 1) read unsigned
+        bool na = negative(*this), nb = negative(a);
+        fixed_uint<Bits> x(na ? -*this : *this), y(nb ? -a : a);
+        x /= y;
+        *this = fixed_int(x);
+        if (na != nb)
+        {
+            detail::fixed_neg(w, w);
+        }
+        return *this;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> &fixed_int<Bits>::operator%=(const fixed_int &a)
+    {
+        if (detail::fixed_zero(a.w))
+        {
+            throw std::invalid_argument("cannot divide by zero");
+        }
+
+        bool na = negative(*this), nb = negative(a);
+        fixed_uint<Bits> x(na ? -*this : *this), y(nb ? -a : a);
+        x %= y;
+        *this = fixed_int(x);
+        if (na)
+        {
+            detail::fixed_neg(w, w);
+        }
+        return *this;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> &fixed_int<Bits>::operator++()
+    {
+        return *this += fixed_int(1);
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> fixed_int<Bits>::operator++(int)
+    {
+        fixed_int r = *this;
+        ++*this;
+        return r;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> &fixed_int<Bits>::operator--()
+    {
+        return *this -= fixed_int(1);
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> fixed_int<Bits>::operator--(int)
+    {
+        fixed_int r = *this;
+        --*this;
+        return r;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> &fixed_int<Bits>::operator&=(const fixed_int &a)
+    {
+        detail::unroll<limb_count>([&](auto i)
+        {
+            w[i] &= a.w[i];
+        });
+        return *this;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> &fixed_int<Bits>::operator|=(const fixed_int &a)
+    {
+        detail::unroll<limb_count>([&](auto i)
+        {
+            w[i] |= a.w[i];
+        });
+        return *this;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> &fixed_int<Bits>::operator^=(const fixed_int &a)
+    {
+        if (negative(a))
+        {
+            throw std::invalid_argument("negative exponent");
+        }
+
+        // the low Bits bits of the power do not depend on the sign, so raise
+        // the two's complement form as unsigned
+        fixed_uint<Bits> x(*this);
+        x ^= fixed_uint<Bits>(a);
+        w = x.limbs();
+        return *this;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> &fixed_int<Bits>::operator<<=(std::size_t s)
+    {
+        if (s >= Bits)
+        {
+            w = {};
+        }
+        else
+        {
+            detail::fixed_shl(w, w, s);
+        }
+        return *this;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> &fixed_int<Bits>::operator>>=(std::size_t s)
+    {
+        detail::limb_t fill = negative(*this) ? ~detail::limb_t(0) : 0;
+        if (s >= Bits)
+        {
+            w.fill(fill);
+        }
+        else
+        {
+            detail::fixed_shr(w, w, s, fill);
+        }
+        return *this;
+    }
+
+    template <std::size_t Bits>
+    constexpr int fixed_int<Bits>::cmp(const fixed_int &a, const fixed_int &b)
+    {
+        // a negative number is below every other one, and two of one sign
+        // compare as their bits do
+        bool na = negative(a), nb = negative(b);
+        if (na != nb)
+        {
+            return na ? -1 : 1;
+        }
+        return detail::fixed_cmp(a.w, b.w);
+    }
+
+    template <std::size_t Bits>
+    constexpr bool add_overflow(const fixed_uint<Bits> &a, const fixed_uint<Bits> &b, fixed_uint<Bits> &r)
+    {
+        return detail::fixed_add(r.limbs(), a.limbs(), b.limbs());
+    }
+
+    template <std::size_t Bits>
+    constexpr bool sub_overflow(const fixed_uint<Bits> &a, const fixed_uint<Bits> &b, fixed_uint<Bits> &r)
+    {
+        return detail::fixed_sub(r.limbs(), a.limbs(), b.limbs());
+    }
+
+    template <std::size_t Bits>
+    constexpr bool mul_overflow(const fixed_uint<Bits> &a, const fixed_uint<Bits> &b, fixed_uint<Bits> &r)
+    {
+        return detail::fixed_mul(r.limbs(), a.limbs(), b.limbs());
+    }
+
+    template <std::size_t Bits>
+    constexpr bool add_overflow(const fixed_int<Bits> &a, const fixed_int<Bits> &b, fixed_int<Bits> &r)
+    {
+        // only operands of one sign can overflow, and then the sum has the other
+        bool na = negative(a), nb = negative(b);
+        r = a + b;
+        return na == nb && negative(r) != na;
+    }
+
+    template <std::size_t Bits>
+    constexpr bool sub_overflow(const fixed_int<Bits> &a, const fixed_int<Bits> &b, fixed_int<Bits> &r)
+    {
+        bool na = negative(a), nb = negative(b);
+        r = a - b;
+        return na != nb && negative(r) != na;
+    }
+
+    template <std::size_t Bits>
+    constexpr bool mul_overflow(const fixed_int<Bits> &a, const fixed_int<Bits> &b, fixed_int<Bits> &r)
+    {
+        // the product of the magnitudes must fit below 2^(Bits - 1), or be
+        // equal to it for a negative product
+        bool na = negative(a), nb = negative(b);
+        fixed_uint<Bits> x(na ? -a : a), y(nb ? -b : b), m;
+        bool over = mul_overflow(x, y, m);
+        fixed_int<Bits> p(m);
+        if (negative(p))
+        {
+            over = over || na == nb || p != fixed_int<Bits>::min();
+        }
+        r = (na != nb) ? -p : p;
+        return over;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits> checked_add(const fixed_uint<Bits> &a, const fixed_uint<Bits> &b)
+    {
+        fixed_uint<Bits> r;
+        if (add_overflow(a, b, r))
+        {
+            throw std::overflow_error("overflow. a + b does not fit the fixed width");
+        }
+        return r;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits> checked_sub(const fixed_uint<Bits> &a, const fixed_uint<Bits> &b)
+    {
+        fixed_uint<Bits> r;
+        if (sub_overflow(a, b, r))
+        {
+            throw std::underflow_error("underflow. a cannot be less than b");
+        }
+        return r;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_uint<Bits> checked_mul(const fixed_uint<Bits> &a, const fixed_uint<Bits> &b)
+    {
+        fixed_uint<Bits> r;
+        if (mul_overflow(a, b, r))
+        {
+            throw std::overflow_error("overflow. a * b does not fit the fixed width");
+        }
+        return r;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> checked_add(const fixed_int<Bits> &a, const fixed_int<Bits> &b)
+    {
+        fixed_int<Bits> r;
+        if (add_overflow(a, b, r))
+        {
+            throw std::overflow_error("overflow. a + b does not fit the fixed width");
+        }
+        return r;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> checked_sub(const fixed_int<Bits> &a, const fixed_int<Bits> &b)
+    {
+        fixed_int<Bits> r;
+        if (sub_overflow(a, b, r))
+        {
+            throw std::overflow_error("overflow. a - b does not fit the fixed width");
+        }
+        return r;
+    }
+
+    template <std::size_t Bits>
+    constexpr fixed_int<Bits> checked_mul(const fixed_int<Bits> &a, const fixed_int<Bits> &b)
+    {
+        fixed_int<Bits> r;
+        if (mul_overflow(a, b, r))
+        {
+            throw std::overflow_error("overflow. a * b does not fit the fixed width");
+        }
+        return r;
+    }
+}
+
+#endif
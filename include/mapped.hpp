@@ -0,0 +1,317 @@
+#ifndef mapped_hpp
+#define mapped_hpp
+
+#include <algorithm>
+#include <cerrno>
+#include <string>
+#include <system_error>
+#include <bint.hpp>
+#include <ubint.hpp>
+#include <binary.hpp>
+
+#if __has_include(<sys/mman.h>) && __has_include(<unistd.h>)
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace estd
+{
+#if __has_include(<sys/mman.h>) && __has_include(<unistd.h>)
+    // out of core numbers. a mapped_resource keeps the limbs of the numbers
+    // it backs in files mapped into memory, so numbers larger than physical
+    // memory live on disk and the kernel pages them through as the
+    // arithmetic runs over them. addition, subtraction and comparison make a
+    // single sequential pass over their operands, and large transforms of
+    // ntt products work depth first in blocks, so the paging stays mostly
+    // sequential. use it with set_memory_resource or for single numbers,
+    // and with set_scratch_resource so the temporaries of products spill too
+
+    // a resource that maps a file of its own for every allocation of at
+    // least threshold bytes, in dir, or in TMPDIR or /tmp if dir is empty.
+    // the files are unlinked as soon as they are made, so they go away with
+    // their mapping even if the process dies. disk space is reserved up
+    // front, so a full disk throws instead of faulting on a later write.
+    // smaller allocations come from upstream, new and delete by default.
+    // thread safe, as long as upstream is
+    class mapped_resource : public memory_resource
+    {
+    public:
+        explicit mapped_resource(std::string dir = std::string(), std::size_t threshold = std::size_t(1) << 20, memory_resource *upstream = nullptr);
+        mapped_resource(const mapped_resource &) = delete;
+        mapped_resource &operator=(const mapped_resource &) = delete;
+
+        const std::string &directory() const;
+        std::size_t threshold() const;
+        memory_resource *upstream() const;
+
+    private:
+        std::string dir;
+        std::size_t limit;
+        memory_resource *up;
+
+        void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override;
+        bool do_is_equal(const memory_resource &other) const noexcept override;
+    };
+
+    // write a to the file at path in the binary format of to_binary,
+    // replacing it. the bytes are written through a mapping of the file, so
+    // a result in a mapped_resource goes from one file to the other without
+    // a copy of the whole number in memory
+    void save(const std::string &path, const ubint &a);
+    void save(const std::string &path, const bint &a);
+    // read the number saved in the file at path into a, allocating from the
+    // resource of a. throws as from_binary does, or if bytes follow the number
+    void load(const std::string &path, ubint &a);
+    void load(const std::string &path, bint &a);
+
+    namespace detail
+    {
+        // throw a system_error for errno, naming the call that failed
+        [[noreturn]] void throw_errno(const char *what);
+
+        // a file mapped into memory, shared with the file if it is writable.
+        // unmaps it and closes the descriptor when destroyed
+        class file_map
+        {
+        public:
+            // takes over fd, closing it if the mapping fails
+            file_map(int fd, std::size_t n, bool writable);
+            ~file_map();
+            file_map(const file_map &) = delete;
+            file_map &operator=(const file_map &) = delete;
+
+            std::byte *data() const;
+            std::size_t size() const;
+
+        private:
+            int fd;
+            void *p;
+            std::size_t n;
+        };
+
+        // an unlinked file of bytes bytes in dir, open for reading and writing
+        int temporary_file(const std::string &dir, std::size_t bytes);
+
+        template <typename T>
+        void save(const std::string &path, const T &a);
+        template <typename T>
+        void load(const std::string &path, T &a);
+    }
+
+    namespace detail
+    {
+        void throw_errno(const char *what)
+        {
+            throw std::system_error(errno, std::generic_category(), what);
+        }
+
+        file_map::file_map(int fd, std::size_t n, bool writable) : fd(fd), p(nullptr), n(n)
+        {
+            if (n == 0)
+            {
+                return;
+            }
+
+            int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+            p = mmap(nullptr, n, prot, writable ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED)
+            {
+                int e = errno;
+                close(fd);
+                errno = e;
+                throw_errno("mmap");
+            }
+        }
+
+        file_map::~file_map()
+        {
+            if (p)
+            {
+                munmap(p, n);
+            }
+            close(fd);
+        }
+
+        std::byte *file_map::data() const
+        {
+            return static_cast<std::byte *>(p);
+        }
+
+        std::size_t file_map::size() const
+        {
+            return n;
+        }
+
+        int temporary_file(const std::string &dir, std::size_t bytes)
+        {
+            int fd = -1;
+        #if defined(O_TMPFILE)
+            // a file that never has a name, where the file system allows it
+            fd = open(dir.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+        #endif
+            if (fd < 0)
+            {
+                std::string name = dir + "/estd-XXXXXX";
+                fd = mkstemp(&name[0]);
+                if (fd < 0)
+                {
+                    throw_errno("mkstemp");
+                }
+                unlink(name.c_str());
+            }
+
+            int e = posix_fallocate(fd, 0, (off_t)bytes);
+            if (e != 0)
+            {
+                close(fd);
+                errno = e;
+                throw_errno("posix_fallocate");
+            }
+
+            return fd;
+        }
+
+        template <typename T>
+        void save(const std::string &path, const T &a)
+        {
+            int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0)
+            {
+                throw_errno("open");
+            }
+
+            std::size_t n = binary_size(a);
+            if (ftruncate(fd, (off_t)n) != 0)
+            {
+                int e = errno;
+                close(fd);
+                errno = e;
+                throw_errno("ftruncate");
+            }
+
+            file_map f(fd, n, true);
+            to_binary(a, f.data(), n);
+        }
+
+        template <typename T>
+        void load(const std::string &path, T &a)
+        {
+            int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+            {
+                throw_errno("open");
+            }
+
+            struct stat st;
+            if (fstat(fd, &st) != 0)
+            {
+                int e = errno;
+                close(fd);
+                errno = e;
+                throw_errno("fstat");
+            }
+
+            file_map f(fd, (std::size_t)st.st_size, false);
+            // the number is read in order, so let the kernel read ahead
+            if (f.size())
+            {
+                madvise(f.data(), f.size(), MADV_SEQUENTIAL);
+            }
+
+            if (from_binary(f.data(), f.size(), a) != f.size())
+            {
+                throw std::invalid_argument("trailing bytes after the number");
+            }
+        }
+    }
+
+    mapped_resource::mapped_resource(std::string dir, std::size_t threshold, memory_resource *upstream)
+        : dir(std::move(dir)), limit(std::max<std::size_t>(threshold, 1)), up(upstream ? upstream : detail::default_resource())
+    {
+        if (this->dir.empty())
+        {
+            const char *t = std::getenv("TMPDIR");
+            this->dir = (t && *t) ? t : "/tmp";
+        }
+    }
+
+    const std::string &mapped_resource::directory() const
+    {
+        return dir;
+    }
+
+    std::size_t mapped_resource::threshold() const
+    {
+        return limit;
+    }
+
+    memory_resource *mapped_resource::upstream() const
+    {
+        return up;
+    }
+
+    void *mapped_resource::do_allocate(std::size_t bytes, std::size_t alignment)
+    {
+        if (bytes < limit)
+        {
+            return up->allocate(bytes, alignment);
+        }
+
+        // mappings are page aligned, which covers any alignment limbs need.
+        // the descriptor can go once the file is mapped
+        int fd = detail::temporary_file(dir, bytes);
+        void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        int e = errno;
+        close(fd);
+        if (p == MAP_FAILED)
+        {
+            errno = e;
+            detail::throw_errno("mmap");
+        }
+
+        return p;
+    }
+
+    void mapped_resource::do_deallocate(void *p, std::size_t bytes, std::size_t alignment)
+    {
+        if (bytes < limit)
+        {
+            up->deallocate(p, bytes, alignment);
+            return;
+        }
+
+        munmap(p, bytes);
+    }
+
+    bool mapped_resource::do_is_equal(const memory_resource &other) const noexcept
+    {
+        return this == &other;
+    }
+
+    void save(const std::string &path, const ubint &a)
+    {
+        detail::save(path, a);
+    }
+
+    void save(const std::string &path, const bint &a)
+    {
+        detail::save(path, a);
+    }
+
+    void load(const std::string &path, ubint &a)
+    {
+        detail::load(path, a);
+    }
+
+    void load(const std::string &path, bint &a)
+    {
+        detail::load(path, a);
+    }
+#endif
+}
+
+#endif
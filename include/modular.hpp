@@ -0,0 +1,967 @@
+#ifndef modular_hpp
+#define modular_hpp
+
+#include <bint.hpp>
+#include <ubint.hpp>
+
+namespace estd
+{
+    // base^exp mod m, keeping every intermediate below m. odd moduli use
+    // montgomery multiplication and even ones barrett reduction, both with a
+    // sliding window over the bits of exp. throws if m is zero
+    ubint powmod(const ubint &base, const ubint &exp, const ubint &m);
+    // base^exp mod m for m > 0 and exp >= 0, in the range [0, m). a negative
+    // base is taken mod m first
+    bint powmod(const bint &base, const bint &exp, const bint &m);
+
+    namespace detail
+    {
+        // arithmetic modulo an odd n limb m on numbers in montgomery form,
+        // a R mod m with R = B^n, where a product only needs a multiplication
+        // and n single limb steps to reduce, and no division
+        class montgomery
+        {
+        public:
+            // an empty context, to be assigned one for a modulus
+            montgomery();
+            // m must be odd and have a non zero top limb
+            montgomery(const limb_t *m, std::size_t n);
+
+            // the number of limbs of m, and of every operand and result
+            std::size_t size() const;
+            // r = a b R^-1 mod m. r may be a or b
+            void mul(limb_t *r, const limb_t *a, const limb_t *b) const;
+            // r = a^2 R^-1 mod m. r may be a
+            void sqr(limb_t *r, const limb_t *a) const;
+            // r = a R mod m, the montgomery form of a < m. r may be a
+            void to(limb_t *r, const limb_t *a) const;
+            // r = a R^-1 mod m, back from montgomery form. r may be a
+            void from(limb_t *r, const limb_t *a) const;
+            // r = R mod m, the montgomery form of one
+            void one(limb_t *r) const;
+
+        private:
+            // r = t R^-1 mod m, for a 2n limb t below m R. t is overwritten
+            void redc(limb_t *r, limb_t *t) const;
+
+            std::vector<limb_t> m;
+            // R^2 mod m
+            std::vector<limb_t> r2;
+            // -m^-1 mod B
+            limb_t minv;
+        };
+
+        // arithmetic modulo any n limb m, by barrett reduction of the plain
+        // product with a precomputed reciprocal of m
+        class barrett
+        {
+        public:
+            // an empty context, to be assigned one for a modulus
+            barrett();
+            // m must be above one and have a non zero top limb
+            barrett(const limb_t *m, std::size_t n);
+
+            // the number of limbs of m, and of every operand and result
+            std::size_t size() const;
+            // r = a b mod m. r may be a or b
+            void mul(limb_t *r, const limb_t *a, const limb_t *b) const;
+            // r = a^2 mod m. r may be a
+            void sqr(limb_t *r, const limb_t *a) const;
+            // numbers are kept as they are, these only copy a < m to r
+            void to(limb_t *r, const limb_t *a) const;
+            void from(limb_t *r, const limb_t *a) const;
+            // r = 1
+            void one(limb_t *r) const;
+
+        private:
+            // r = t mod m, for a 2n limb t. t is overwritten
+            void reduce(limb_t *r, limb_t *t) const;
+
+            std::vector<limb_t> m;
+            // floor(B^2n / m)
+            std::vector<limb_t> mu;
+        };
+
+        // bit i of a
+        bool test_bit(const limb_t *a, std::size_t i);
+
+        // a^-1 mod m by the extended euclidean algorithm. throws if a and m
+        // have a common factor
+        ubint invert(const ubint &a, const ubint &m);
+
+        // r = a^e in the arithmetic of ctx, montgomery or barrett, where e is
+        // en limbs with a non zero top limb. a and r are ctx.size() limbs in
+        // the representation of ctx. r must not overlap a
+        template <typename Ctx>
+        void pow_window(limb_t *r, const limb_t *a, const limb_t *e, std::size_t en, const Ctx &ctx);
+
+        montgomery::montgomery() : minv(0) {}
+
+        montgomery::montgomery(const limb_t *m, std::size_t n) : m(m, m + n), r2(n)
+        {
+            // an odd x is its own inverse mod 8, and each newton step
+            // x = x (2 - m x) doubles the number of correct low bits
+            limb_t x = m[0];
+            for (int bits = 3; bits < limb_bits; bits *= 2)
+            {
+                x *= 2 - m[0] * x;
+            }
+            minv = -x;
+
+            // R^2 mod m = B^2n mod m
+            scratch_vector num(2 * n + 1, 0), q(2 * n + 1);
+            num[2 * n] = 1;
+            if (n == 1)
+            {
+                r2[0] = divrem_1(q.data(), num.data(), 3, m[0]);
+            }
+            else
+            {
+                divrem(q.data(), r2.data(), num.data(), 2 * n + 1, m, n);
+            }
+        }
+
+        std::size_t montgomery::size() const
+        {
+            return m.size();
+        }
+
+        void montgomery::mul(limb_t *r, const limb_t *a, const limb_t *b) const
+        {
+            std::size_t n = m.size();
+            scratch_vector t(2 * n);
+            mul_n(t.data(), a, b, n);
+            redc(r, t.data());
+        }
+
+        void montgomery::sqr(limb_t *r, const limb_t *a) const
+        {
+            std::size_t n = m.size();
+            scratch_vector t(2 * n);
+            detail::sqr(t.data(), a, n);
+            redc(r, t.data());
+        }
+
+        void montgomery::to(limb_t *r, const limb_t *a) const
+        {
+            mul(r, a, r2.data());
+        }
+
+        void montgomery::from(limb_t *r, const limb_t *a) const
+        {
+            std::size_t n = m.size();
+            scratch_vector t(2 * n, 0);
+            std::copy(a, a + n, t.begin());
+            redc(r, t.data());
+        }
+
+        void montgomery::one(limb_t *r) const
+        {
+            from(r, r2.data());
+        }
+
+        void montgomery::redc(limb_t *r, limb_t *t) const
+        {
+            // add multiples of m to clear the low limbs of t one at a time,
+            // then t / R is t R^-1 mod m, give or take one m
+            std::size_t n = m.size();
+            limb_t hi = 0;
+            for (std::size_t i = 0; i < n; i++)
+            {
+                limb_t c = addmul_1(t + i, m.data(), n, t[i] * minv);
+                dlimb_t s = (dlimb_t)t[i + n] + c + hi;
+                t[i + n] = (limb_t)s;
+                hi = (limb_t)(s >> limb_bits);
+            }
+
+            if (hi || cmp_n(t + n, m.data(), n) >= 0)
+            {
+                sub_n(r, t + n, m.data(), n);
+            }
+            else
+            {
+                std::copy(t + n, t + 2 * n, r);
+            }
+        }
+
+        barrett::barrett() {}
+
+        barrett::barrett(const limb_t *m, std::size_t n) : m(m, m + n), mu(n + 2)
+        {
+            // mu is at most B^(n + 1), so n + 2 limbs
+            scratch_vector num(2 * n + 1, 0), rem(n);
+            num[2 * n] = 1;
+            if (n == 1)
+            {
+                divrem_1(mu.data(), num.data(), 3, m[0]);
+            }
+            else
+            {
+                divrem(mu.data(), rem.data(), num.data(), 2 * n + 1, m, n);
+            }
+            mu.resize(normalized_size(mu.data(), mu.size()));
+        }
+
+        std::size_t barrett::size() const
+        {
+            return m.size();
+        }
+
+        void barrett::mul(limb_t *r, const limb_t *a, const limb_t *b) const
+        {
+            std::size_t n = m.size();
+            scratch_vector t(2 * n);
+            mul_n(t.data(), a, b, n);
+            reduce(r, t.data());
+        }
+
+        void barrett::sqr(limb_t *r, const limb_t *a) const
+        {
+            std::size_t n = m.size();
+            scratch_vector t(2 * n);
+            detail::sqr(t.data(), a, n);
+            reduce(r, t.data());
+        }
+
+        void barrett::to(limb_t *r, const limb_t *a) const
+        {
+            std::copy(a, a + m.size(), r);
+        }
+
+        void barrett::from(limb_t *r, const limb_t *a) const
+        {
+            std::copy(a, a + m.size(), r);
+        }
+
+        void barrett::one(limb_t *r) const
+        {
+            std::fill(r, r + m.size(), 0);
+            r[0] = 1;
+        }
+
+        void barrett::reduce(limb_t *r, limb_t *t) const
+        {
+            // q = floor(floor(t / B^(n - 1)) mu / B^(n + 1)) is at most two
+            // below t / m, so t - q m < 3m fits in the low n + 1 limbs
+            std::size_t n = m.size(), k = mu.size();
+            const limb_t *x = t + n - 1;
+            scratch_vector p(n + 1 + k, 0), qm(k + n, 0);
+            if (n < 2 * mul_config().karatsuba)
+            {
+                // only the high limbs of x mu and the low n + 1 limbs of q m
+                // are needed. leaving out the products below limb n - 1 of
+                // x mu takes at most one more off q, still well within n + 1
+                // limbs, and halves the work of both products
+                for (std::size_t j = 0; j < k; j++)
+                {
+                    std::size_t i = j < n - 1 ? n - 1 - j : 0;
+                    p[n + 1 + j] = addmul_1(&p[i + j], x + i, n + 1 - i, mu[j]);
+                }
+
+                const limb_t *q = &p[n + 1];
+                for (std::size_t j = 0; j < k && j <= n; j++)
+                {
+                    std::size_t len = std::min(n, n + 1 - j);
+                    limb_t c = addmul_1(&qm[j], m.data(), len, q[j]);
+                    if (j + len <= n)
+                    {
+                        qm[j + len] += c;
+                    }
+                }
+            }
+            else
+            {
+                detail::mul(p.data(), x, n + 1, mu.data(), k);
+                detail::mul(qm.data(), p.data() + n + 1, k, m.data(), n);
+            }
+            sub_n(t, t, qm.data(), n + 1);
+
+            while (t[n] || cmp_n(t, m.data(), n) >= 0)
+            {
+                t[n] -= sub_n(t, t, m.data(), n);
+            }
+            std::copy(t, t + n, r);
+        }
+
+        bool test_bit(const limb_t *a, std::size_t i)
+        {
+            return (a[i / limb_bits] >> (i % limb_bits)) & 1;
+        }
+
+        ubint invert(const ubint &a, const ubint &m)
+        {
+            // u a = 1 + v m, or u a = -1 + v m if swapped
+            ubint u, v;
+            bool swapped;
+            if (gcdext(a % m, m, u, v, swapped) != 1ULL)
+            {
+                throw std::invalid_argument("number has no inverse modulo m");
+            }
+
+            // u <= m, and u = m only for m = 1
+            if (u == m)
+            {
+                return 0ULL;
+            }
+            return (swapped && !null(u)) ? m - u : u;
+        }
+
+        template <typename Ctx>
+        void pow_window(limb_t *r, const limb_t *a, const limb_t *e, std::size_t en, const Ctx &ctx)
+        {
+            std::size_t n = ctx.size();
+            std::size_t bits = en * limb_bits - count_leading_zeros(e[en - 1]);
+
+            // a window of k bits costs one multiplication, against 2^(k - 1)
+            // to precompute the odd powers, so longer exponents take wider ones
+            std::size_t k = bits > 768 ? 6 : bits > 240 ? 5 : bits > 80 ? 4 : bits > 24 ? 3 : bits > 6 ? 2 : 1;
+
+            // g holds a^1, a^3, a^5, ... a^(2^k - 1)
+            std::size_t count = std::size_t(1) << (k - 1);
+            scratch_vector g(count * n);
+            std::copy(a, a + n, g.begin());
+            if (count > 1)
+            {
+                scratch_vector a2(n);
+                ctx.sqr(a2.data(), a);
+                for (std::size_t i = 1; i < count; i++)
+                {
+                    ctx.mul(&g[i * n], &g[(i - 1) * n], a2.data());
+                }
+            }
+
+            // scan e from the top. a zero bit squares, and a set bit starts a
+            // window of at most k bits that also ends on a set bit, so its
+            // value is odd and in the table. the top bit is set, so r is
+            // started from the first window rather than from one
+            bool started = false;
+            std::size_t i = bits;
+            while (i > 0)
+            {
+                if (!test_bit(e, i - 1))
+                {
+                    ctx.sqr(r, r);
+                    i--;
+                    continue;
+                }
+
+                std::size_t j = i > k ? i - k : 0;
+                while (!test_bit(e, j))
+                {
+                    j++;
+                }
+
+                std::size_t w = 0;
+                for (std::size_t b = i; b > j; b--)
+                {
+                    w = w << 1 | test_bit(e, b - 1);
+                }
+
+                const limb_t *p = &g[(w >> 1) * n];
+                if (started)
+                {
+                    for (std::size_t b = j; b < i; b++)
+                    {
+                        ctx.sqr(r, r);
+                    }
+                    ctx.mul(r, r, p);
+                }
+                else
+                {
+                    std::copy(p, p + n, r);
+                    started = true;
+                }
+                i = j;
+            }
+        }
+    }
+
+    class modint;
+
+    // a modulus with its reduction constants, montgomery for an odd modulus
+    // and barrett for an even one, computed once for any number of
+    // operations on its residues. residues stay in the internal form from
+    // residue() until value() converts them back. a modctx must outlive the
+    // residues made from it
+    class modctx
+    {
+    public:
+        // throws if m is zero
+        explicit modctx(const ubint &m);
+
+        // the modulus
+        const ubint &modulus() const;
+
+        // a mod m as a residue
+        modint residue(const ubint &a) const;
+        // a mod m in [0, m), for a negative a as well
+        modint residue(const bint &a) const;
+        // the residues of zero and one
+        modint zero() const;
+        modint one() const;
+        // the value of a residue, in [0, m)
+        ubint value(const modint &a) const;
+
+        // arithmetic on residues of this modulus. throws if an operand
+        // belongs to another modulus
+        modint add(const modint &a, const modint &b) const;
+        modint sub(const modint &a, const modint &b) const;
+        modint mul(const modint &a, const modint &b) const;
+        modint sqr(const modint &a) const;
+        modint neg(const modint &a) const;
+        // a^-1, throws if a and m have a common factor
+        modint inv(const modint &a) const;
+        // a^e
+        modint pow(const modint &a, const ubint &e) const;
+
+        // the same over arrays of count residues, r[i] = a[i] op b[i]. the
+        // residues of r are reused, so a steady loop makes no allocations.
+        // r may be a or b
+        void add(modint *r, const modint *a, const modint *b, std::size_t count) const;
+        void sub(modint *r, const modint *a, const modint *b, std::size_t count) const;
+        void mul(modint *r, const modint *a, const modint *b, std::size_t count) const;
+        void sqr(modint *r, const modint *a, std::size_t count) const;
+        // r[i] = a[i]^-1, with a single inversion for the whole array.
+        // throws if any a[i] has no inverse
+        void inv(modint *r, const modint *a, std::size_t count) const;
+
+    private:
+        friend class modint;
+
+        // the number of limbs of the modulus, and of every residue
+        std::size_t size() const;
+        // throw unless a belongs to this modulus
+        void check(const modint &a) const;
+        // make r a residue of this modulus with room for its limbs
+        void prepare(modint &r) const;
+
+        // the operations on the limbs of residues. r may be a or b
+        void add_limbs(detail::limb_t *r, const detail::limb_t *a, const detail::limb_t *b) const;
+        void sub_limbs(detail::limb_t *r, const detail::limb_t *a, const detail::limb_t *b) const;
+        void mul_limbs(detail::limb_t *r, const detail::limb_t *a, const detail::limb_t *b) const;
+        void sqr_limbs(detail::limb_t *r, const detail::limb_t *a) const;
+
+        ubint m;
+        // odd moduli use mont, even ones barr
+        bool odd;
+        detail::montgomery mont;
+        detail::barrett barr;
+    };
+
+    // a residue modulo the modulus of a modctx
+    class modint
+    {
+    public:
+        // a residue of no modulus, to be assigned one from a modctx
+        modint();
+
+        // the context the residue belongs to, null if none
+        const modctx *context() const;
+        // the value of the residue, in [0, m)
+        ubint value() const;
+
+        // arithmetic, as for the modctx. both operands must belong to the
+        // same modulus
+        friend modint operator+(const modint &a, const modint &b);
+        friend modint operator-(const modint &a, const modint &b);
+        friend modint operator*(const modint &a, const modint &b);
+        friend modint operator-(const modint &a);
+        friend modint &operator+=(modint &a, const modint &b);
+        friend modint &operator-=(modint &a, const modint &b);
+        friend modint &operator*=(modint &a, const modint &b);
+        // a^-1
+        friend modint inv(const modint &a);
+        // a^e
+        friend modint pow(const modint &a, const ubint &e);
+
+        // comparison of residues of the same modulus
+        friend bool operator==(const modint &a, const modint &b);
+        friend bool operator!=(const modint &a, const modint &b);
+
+        // write the value to output stream
+        friend std::ostream &operator<<(std::ostream &out, const modint &a);
+
+    private:
+        friend class modctx;
+
+        // the context of a and b, throws if they do not share one
+        static const modctx &common(const modint &a, const modint &b);
+
+        const modctx *ctx;
+        // the residue, as many limbs as the modulus
+        detail::limb_vector v;
+    };
+
+    ubint powmod(const ubint &base, const ubint &exp, const ubint &m)
+    {
+        if (null(m))
+        {
+            throw std::invalid_argument("modulus cannot be zero");
+        }
+
+        const detail::limb_vector &ml = detail::ubint_access::limbs(m);
+        const detail::limb_vector &el = detail::ubint_access::limbs(exp);
+        std::size_t n = ml.size();
+
+        ubint r(0ULL, base.resource());
+        if (n == 1 && ml[0] == 1)
+        {
+            return r;
+        }
+        if (el.empty())
+        {
+            r = 1;
+            return r;
+        }
+
+        // the base below m, padded to the length of m
+        ubint reduced;
+        const ubint *b = &base;
+        if (base >= m)
+        {
+            reduced = base % m;
+            b = &reduced;
+        }
+        const detail::limb_vector &bl = detail::ubint_access::limbs(*b);
+        detail::scratch_vector x(n, 0), y(n);
+        std::copy(bl.data(), bl.data() + bl.size(), x.begin());
+
+        if (ml[0] & 1)
+        {
+            detail::montgomery ctx(ml.data(), n);
+            ctx.to(x.data(), x.data());
+            detail::pow_window(y.data(), x.data(), el.data(), el.size(), ctx);
+            ctx.from(y.data(), y.data());
+        }
+        else
+        {
+            detail::barrett ctx(ml.data(), n);
+            detail::pow_window(y.data(), x.data(), el.data(), el.size(), ctx);
+        }
+
+        detail::ubint_access::limbs(r).assign(y.data(), n);
+        detail::ubint_access::trim(r);
+        return r;
+    }
+
+    bint powmod(const bint &base, const bint &exp, const bint &m)
+    {
+        if (negative(m) || null(m))
+        {
+            throw std::invalid_argument("modulus must be positive");
+        }
+        if (negative(exp))
+        {
+            throw std::invalid_argument("exponent cannot be negative");
+        }
+
+        const ubint &mm = detail::bint_access::magnitude(m);
+        ubint b = detail::bint_access::magnitude(base) % mm;
+        if (negative(base) && !null(b))
+        {
+            b = mm - b;
+        }
+
+        bint r(0LL, base.resource());
+        detail::bint_access::magnitude(r) = powmod(b, detail::bint_access::magnitude(exp), mm);
+        return r;
+    }
+
+    modctx::modctx(const ubint &m) : m(m), odd(false)
+    {
+        if (null(m))
+        {
+            throw std::invalid_argument("modulus cannot be zero");
+        }
+
+        const detail::limb_vector &ml = detail::ubint_access::limbs(m);
+        odd = ml[0] & 1;
+        if (odd)
+        {
+            mont = detail::montgomery(ml.data(), ml.size());
+        }
+        else
+        {
+            barr = detail::barrett(ml.data(), ml.size());
+        }
+    }
+
+    const ubint &modctx::modulus() const
+    {
+        return m;
+    }
+
+    modint modctx::residue(const ubint &a) const
+    {
+        ubint reduced;
+        const ubint *b = &a;
+        if (a >= m)
+        {
+            reduced = a % m;
+            b = &reduced;
+        }
+
+        modint r;
+        prepare(r);
+        const detail::limb_vector &bl = detail::ubint_access::limbs(*b);
+        std::copy(bl.data(), bl.data() + bl.size(), r.v.data());
+        if (odd)
+        {
+            mont.to(r.v.data(), r.v.data());
+        }
+        return r;
+    }
+
+    modint modctx::residue(const bint &a) const
+    {
+        modint r = residue(detail::bint_access::magnitude(a));
+        return negative(a) ? neg(r) : r;
+    }
+
+    modint modctx::zero() const
+    {
+        modint r;
+        prepare(r);
+        return r;
+    }
+
+    modint modctx::one() const
+    {
+        modint r;
+        prepare(r);
+        if (odd)
+        {
+            mont.one(r.v.data());
+        }
+        else
+        {
+            barr.one(r.v.data());
+        }
+        return r;
+    }
+
+    ubint modctx::value(const modint &a) const
+    {
+        check(a);
+
+        ubint r(0ULL, a.v.resource());
+        detail::limb_vector &rl = detail::ubint_access::limbs(r);
+        rl.assign(a.v.data(), size());
+        if (odd)
+        {
+            mont.from(rl.data(), rl.data());
+        }
+        detail::ubint_access::trim(r);
+        return r;
+    }
+
+    modint modctx::add(const modint &a, const modint &b) const
+    {
+        modint r;
+        add(&r, &a, &b, 1);
+        return r;
+    }
+
+    modint modctx::sub(const modint &a, const modint &b) const
+    {
+        modint r;
+        sub(&r, &a, &b, 1);
+        return r;
+    }
+
+    modint modctx::mul(const modint &a, const modint &b) const
+    {
+        modint r;
+        mul(&r, &a, &b, 1);
+        return r;
+    }
+
+    modint modctx::sqr(const modint &a) const
+    {
+        modint r;
+        sqr(&r, &a, 1);
+        return r;
+    }
+
+    modint modctx::neg(const modint &a) const
+    {
+        check(a);
+
+        modint r;
+        prepare(r);
+        std::size_t n = size();
+        if (detail::normalized_size(a.v.data(), n))
+        {
+            detail::sub_n(r.v.data(), detail::ubint_access::limbs(m).data(), a.v.data(), n);
+        }
+        return r;
+    }
+
+    modint modctx::inv(const modint &a) const
+    {
+        modint r;
+        inv(&r, &a, 1);
+        return r;
+    }
+
+    modint modctx::pow(const modint &a, const ubint &e) const
+    {
+        check(a);
+
+        const detail::limb_vector &el = detail::ubint_access::limbs(e);
+        if (el.empty())
+        {
+            return one();
+        }
+
+        modint r;
+        prepare(r);
+        if (odd)
+        {
+            detail::pow_window(r.v.data(), a.v.data(), el.data(), el.size(), mont);
+        }
+        else
+        {
+            detail::pow_window(r.v.data(), a.v.data(), el.data(), el.size(), barr);
+        }
+        return r;
+    }
+
+    void modctx::add(modint *r, const modint *a, const modint *b, std::size_t count) const
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            check(a[i]);
+            check(b[i]);
+            prepare(r[i]);
+            add_limbs(r[i].v.data(), a[i].v.data(), b[i].v.data());
+        }
+    }
+
+    void modctx::sub(modint *r, const modint *a, const modint *b, std::size_t count) const
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            check(a[i]);
+            check(b[i]);
+            prepare(r[i]);
+            sub_limbs(r[i].v.data(), a[i].v.data(), b[i].v.data());
+        }
+    }
+
+    void modctx::mul(modint *r, const modint *a, const modint *b, std::size_t count) const
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            check(a[i]);
+            check(b[i]);
+            prepare(r[i]);
+            mul_limbs(r[i].v.data(), a[i].v.data(), b[i].v.data());
+        }
+    }
+
+    void modctx::sqr(modint *r, const modint *a, std::size_t count) const
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            check(a[i]);
+            prepare(r[i]);
+            sqr_limbs(r[i].v.data(), a[i].v.data());
+        }
+    }
+
+    void modctx::inv(modint *r, const modint *a, std::size_t count) const
+    {
+        if (!count)
+        {
+            return;
+        }
+
+        // montgomery's trick. with the prefix products p[i] = a[0] ... a[i],
+        // one inversion of p[count - 1] gives every inverse, walking back as
+        // a[i]^-1 = p[i]^-1 p[i - 1] and p[i - 1]^-1 = p[i]^-1 a[i]
+        std::size_t n = size();
+        detail::scratch_vector p(count * n), t(n), u(n);
+        check(a[0]);
+        std::copy(a[0].v.data(), a[0].v.data() + n, p.begin());
+        for (std::size_t i = 1; i < count; i++)
+        {
+            check(a[i]);
+            mul_limbs(&p[i * n], &p[(i - 1) * n], a[i].v.data());
+        }
+
+        modint last;
+        prepare(last);
+        std::copy(&p[(count - 1) * n], &p[(count - 1) * n] + n, last.v.data());
+        modint x = residue(detail::invert(value(last), m));
+        std::copy(x.v.data(), x.v.data() + n, t.begin());
+
+        for (std::size_t i = count - 1; i > 0; i--)
+        {
+            // a[i] is read before r[i] is written, as they may be the same
+            mul_limbs(u.data(), t.data(), a[i].v.data());
+            prepare(r[i]);
+            mul_limbs(r[i].v.data(), t.data(), &p[(i - 1) * n]);
+            t.swap(u);
+        }
+        prepare(r[0]);
+        std::copy(t.begin(), t.end(), r[0].v.data());
+    }
+
+    std::size_t modctx::size() const
+    {
+        return detail::ubint_access::limbs(m).size();
+    }
+
+    void modctx::check(const modint &a) const
+    {
+        if (a.ctx != this)
+        {
+            throw std::invalid_argument("residue belongs to another modulus");
+        }
+    }
+
+    void modctx::prepare(modint &r) const
+    {
+        r.ctx = this;
+        r.v.resize(size());
+    }
+
+    void modctx::add_limbs(detail::limb_t *r, const detail::limb_t *a, const detail::limb_t *b) const
+    {
+        std::size_t n = size();
+        const detail::limb_t *ml = detail::ubint_access::limbs(m).data();
+        if (detail::add_n(r, a, b, n) || detail::cmp_n(r, ml, n) >= 0)
+        {
+            detail::sub_n(r, r, ml, n);
+        }
+    }
+
+    void modctx::sub_limbs(detail::limb_t *r, const detail::limb_t *a, const detail::limb_t *b) const
+    {
+        std::size_t n = size();
+        if (detail::sub_n(r, a, b, n))
+        {
+            detail::add_n(r, r, detail::ubint_access::limbs(m).data(), n);
+        }
+    }
+
+    void modctx::mul_limbs(detail::limb_t *r, const detail::limb_t *a, const detail::limb_t *b) const
+    {
+        if (odd)
+        {
+            mont.mul(r, a, b);
+        }
+        else
+        {
+            barr.mul(r, a, b);
+        }
+    }
+
+    void modctx::sqr_limbs(detail::limb_t *r, const detail::limb_t *a) const
+    {
+        if (odd)
+        {
+            mont.sqr(r, a);
+        }
+        else
+        {
+            barr.sqr(r, a);
+        }
+    }
+
+    modint::modint() : ctx(nullptr) {}
+
+    const modctx *modint::context() const
+    {
+        return ctx;
+    }
+
+    ubint modint::value() const
+    {
+        if (!ctx)
+        {
+            throw std::invalid_argument("residue has no modulus");
+        }
+
+        return ctx->value(*this);
+    }
+
+    const modctx &modint::common(const modint &a, const modint &b)
+    {
+        if (!a.ctx || a.ctx != b.ctx)
+        {
+            throw std::invalid_argument("residues must share a modulus");
+        }
+
+        return *a.ctx;
+    }
+
+    modint operator+(const modint &a, const modint &b)
+    {
+        return modint::common(a, b).add(a, b);
+    }
+
+    modint operator-(const modint &a, const modint &b)
+    {
+        return modint::common(a, b).sub(a, b);
+    }
+
+    modint operator*(const modint &a, const modint &b)
+    {
+        return modint::common(a, b).mul(a, b);
+    }
+
+    modint operator-(const modint &a)
+    {
+        return modint::common(a, a).neg(a);
+    }
+
+    modint &operator+=(modint &a, const modint &b)
+    {
+        modint::common(a, b).add(&a, &a, &b, 1);
+        return a;
+    }
+
+    modint &operator-=(modint &a, const modint &b)
+    {
+        modint::common(a, b).sub(&a, &a, &b, 1);
+        return a;
+    }
+
+    modint &operator*=(modint &a, const modint &b)
+    {
+        modint::common(a, b).mul(&a, &a, &b, 1);
+        return a;
+    }
+
+    modint inv(const modint &a)
+    {
+        return modint::common(a, a).inv(a);
+    }
+
+    modint pow(const modint &a, const ubint &e)
+    {
+        return modint::common(a, a).pow(a, e);
+    }
+
+    bool operator==(const modint &a, const modint &b)
+    {
+        modint::common(a, b);
+        return a.v == b.v;
+    }
+
+    bool operator!=(const modint &a, const modint &b)
+    {
+        return !(a == b);
+    }
+
+    std::ostream &operator<<(std::ostream &out, const modint &a)
+    {
+        out << a.value();
+
+        return out;
+    }
+}
+
+#endif
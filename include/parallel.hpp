@@ -0,0 +1,116 @@
+#ifndef parallel_hpp
+#define parallel_hpp
+
+#include <bint.hpp>
+#include <ubint.hpp>
+
+// the standard execution policies. kept out of estd.hpp, as some standard
+// libraries need an extra library linked (tbb for libstdc++) once <execution>
+// is included
+#if __has_include(<execution>)
+#include <execution>
+#endif
+
+#if defined(__cpp_lib_execution)
+
+namespace estd
+{
+    // a * b on the calling thread only, whatever its size
+    ubint multiply(const std::execution::sequenced_policy &, const ubint &a, const ubint &b);
+    bint multiply(const std::execution::sequenced_policy &, const bint &a, const bint &b);
+    // a * b split into tasks for the thread pool whatever its size, as long
+    // as get_thread_count() is more than one. the subproducts still use the
+    // pool only above the parallel threshold
+    ubint multiply(const std::execution::parallel_policy &, const ubint &a, const ubint &b);
+    bint multiply(const std::execution::parallel_policy &, const bint &a, const bint &b);
+    ubint multiply(const std::execution::parallel_unsequenced_policy &, const ubint &a, const ubint &b);
+    bint multiply(const std::execution::parallel_unsequenced_policy &, const bint &a, const bint &b);
+
+    namespace detail
+    {
+        // a * b, splitting the top level product if parallel is set and the
+        // whole product otherwise serial if serial is set
+        ubint multiply(const ubint &a, const ubint &b, bool parallel, bool serial);
+        bint multiply(const bint &a, const bint &b, bool parallel, bool serial);
+
+        ubint multiply(const ubint &a, const ubint &b, bool parallel, bool serial)
+        {
+            ubint r(0ULL, a.resource());
+            const limb_vector &x = ubint_access::limbs(a), &y = ubint_access::limbs(b);
+            if (x.empty() || y.empty())
+            {
+                return r;
+            }
+
+            limb_vector &z = ubint_access::limbs(r);
+            z.resize(x.size() + y.size());
+
+            // restore the serial flag of the calling thread even if mul throws
+            struct scope
+            {
+                bool saved;
+
+                scope(bool serial) : saved(serial_scope())
+                {
+                    serial_scope() = saved || serial;
+                }
+
+                ~scope()
+                {
+                    serial_scope() = saved;
+                }
+            } s(serial);
+
+            parallel = parallel && !serial_scope() && thread_count() > 1;
+            mul(z.data(), x.data(), x.size(), y.data(), y.size(), parallel);
+            ubint_access::trim(r);
+
+            return r;
+        }
+
+        bint multiply(const bint &a, const bint &b, bool parallel, bool serial)
+        {
+            // the product comes from the resource of a, as for ubint
+            bint r(0LL, a.resource());
+            ubint &m = bint_access::magnitude(r);
+            m = multiply(bint_access::magnitude(a), bint_access::magnitude(b), parallel, serial);
+            bint_access::sign(r) = !null(m) && bint_access::sign(a) != bint_access::sign(b);
+
+            return r;
+        }
+    }
+
+    ubint multiply(const std::execution::sequenced_policy &, const ubint &a, const ubint &b)
+    {
+        return detail::multiply(a, b, false, true);
+    }
+
+    bint multiply(const std::execution::sequenced_policy &, const bint &a, const bint &b)
+    {
+        return detail::multiply(a, b, false, true);
+    }
+
+    ubint multiply(const std::execution::parallel_policy &, const ubint &a, const ubint &b)
+    {
+        return detail::multiply(a, b, true, false);
+    }
+
+    bint multiply(const std::execution::parallel_policy &, const bint &a, const bint &b)
+    {
+        return detail::multiply(a, b, true, false);
+    }
+
+    ubint multiply(const std::execution::parallel_unsequenced_policy &, const ubint &a, const ubint &b)
+    {
+        return detail::multiply(a, b, true, false);
+    }
+
+    bint multiply(const std::execution::parallel_unsequenced_policy &, const bint &a, const bint &b)
+    {
+        return detail::multiply(a, b, true, false);
+    }
+}
+
+#endif
+
+#endif
@@ -1,19 +1,650 @@
 #ifndef ubint_hpp
 #define ubint_hpp
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#if defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#endif
+#endif
+
+#if defined(__SIZEOF_INT128__) && defined(__x86_64__) && defined(__GNUC__)
+#include <cpuid.h>
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 namespace estd
 {
+    // operand sizes, in limbs, at which multiplication switches to the next
+    // algorithm. the smaller operand decides which algorithm is used
+    struct mul_thresholds
+    {
+        // schoolbook below this, karatsuba above
+        std::size_t karatsuba = 32;
+        // karatsuba below this, toom-3 above
+        std::size_t toom3 = 800;
+        // toom-3 below this, toom-4 above
+        std::size_t toom4 = 2500;
+        // toom-4 below this, number theoretic transform above
+        std::size_t ntt = 4000;
+        // products at least this long split their subproducts and transforms
+        // into tasks for the thread pool
+        std::size_t parallel = 8000;
+    };
+
+    // get the multiplication thresholds in use
+    mul_thresholds get_mul_thresholds();
+    // override the multiplication thresholds, to tune them for a host.
+    // not thread safe, set them before multiplying on other threads
+    void set_mul_thresholds(const mul_thresholds &);
+
+    // get the number of threads a large product may use, the calling thread
+    // included
+    std::size_t get_thread_count();
+    // set the number of threads a large product may use. 0 uses every
+    // hardware thread, the default, and 1 keeps products on the calling
+    // thread. not thread safe, set it before multiplying on other threads
+    void set_thread_count(std::size_t n);
+
+    // operand sizes, in limbs, at which division switches to the next algorithm
+    struct div_thresholds
+    {
+        // knuth's schoolbook division below this, newton reciprocal above.
+        // both the divisor and the quotient must be at least this long
+        std::size_t newton = 1200;
+    };
+
+    // get the division thresholds in use
+    div_thresholds get_div_thresholds();
+    // override the division thresholds, to tune them for a host.
+    // not thread safe, set them before dividing on other threads
+    void set_div_thresholds(const div_thresholds &);
+
+    // operand sizes, in limbs, at which gcd switches to the next algorithm.
+    // numbers of up to two limbs use the binary algorithm
+    struct gcd_thresholds
+    {
+        // lehmer's algorithm below this, half gcd above
+        std::size_t hgcd = 600;
+        // the half gcd recurses on the top halves of operands at least this
+        // long, and takes lehmer steps on shorter ones
+        std::size_t hgcd_recurse = 100;
+    };
+
+    // get the gcd thresholds in use
+    gcd_thresholds get_gcd_thresholds();
+    // override the gcd thresholds, to tune them for a host.
+    // not thread safe, set them before taking gcds on other threads
+    void set_gcd_thresholds(const gcd_thresholds &);
+
+    // the instruction sets the limb kernels, the inner loops of addition,
+    // subtraction and multiplication, can be built on
+    enum class limb_kernels
+    {
+        // plain c++, for any cpu
+        portable,
+        // the adx and bmi2 extensions of x86-64: mulx, and additions that
+        // carry through either the carry or the overflow flag
+        adx
+    };
+
+    // get the kernels in use, the best the cpu has by default
+    limb_kernels get_limb_kernels();
+    // switch the kernels in use, for instance to test the portable ones on a
+    // cpu that has adx. asking for kernels the cpu or the compiler lacks
+    // picks the portable ones. not thread safe, set them before computing on
+    // other threads
+    void set_limb_kernels(limb_kernels k);
+
+    // the polymorphic resource that ubint and bint allocate their limbs from
+#if defined(__cpp_lib_memory_resource)
+    typedef std::pmr::memory_resource memory_resource;
+#else
+    // a minimal stand in for std::pmr::memory_resource, for libraries that
+    // do not have it yet
+    class memory_resource
+    {
+    public:
+        virtual ~memory_resource() {}
+
+        void *allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t));
+        void deallocate(void *p, std::size_t bytes, std::size_t alignment = alignof(std::max_align_t));
+        bool is_equal(const memory_resource &other) const noexcept;
+
+    private:
+        virtual void *do_allocate(std::size_t bytes, std::size_t alignment) = 0;
+        virtual void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) = 0;
+        virtual bool do_is_equal(const memory_resource &other) const noexcept = 0;
+    };
+#endif
+
+    // get the resource new numbers allocate from, new and delete by default
+    memory_resource *get_memory_resource();
+    // change the resource new numbers allocate from. null restores new and
+    // delete. not thread safe, set it before making numbers on other threads
+    void set_memory_resource(memory_resource *r);
+
+    // free the scratch memory the calling thread keeps for the temporaries of
+    // multiplication and division. it is reused between operations, so this
+    // only gives it back to the heap
+    void release_scratch();
+
+    // get the resource large temporaries come from, or null when they come
+    // from the scratch memory of the thread, the default
+    memory_resource *get_scratch_resource();
+    // allocate the temporaries of at least bytes bytes from r instead of the
+    // scratch memory, for instance from a mapped_resource so that products of
+    // numbers larger than memory spill to disk as well. null restores the
+    // scratch memory. not thread safe, set it before computing on other threads
+    void set_scratch_resource(memory_resource *r, std::size_t bytes = std::size_t(1) << 24);
+
+    namespace detail
+    {
+        // limb types. numbers are stored in base 2^limb_bits, with a double
+        // width type to hold the intermediate products and carries
+    #if defined(__SIZEOF_INT128__)
+        typedef std::uint64_t limb_t;
+        typedef unsigned __int128 dlimb_t;
+
+        // the largest power of 10 that fits in a limb, and its exponent
+        const limb_t dec_base = 10000000000000000000ULL;
+        const int dec_digits = 19;
+    #else
+        typedef std::uint32_t limb_t;
+        typedef std::uint64_t dlimb_t;
+
+        // the largest power of 10 that fits in a limb, and its exponent
+        const limb_t dec_base = 1000000000UL;
+        const int dec_digits = 9;
+    #endif
+
+        // number of bits in a limb
+        const int limb_bits = sizeof(limb_t) * 8;
+
+        // a per thread stack of memory for the temporaries of the kernels.
+        // blocks may be freed in any order, but are only reclaimed from the
+        // top, so the arena is empty again once each top level operation has
+        // unwound. the chunks are kept, so a steady workload makes no heap calls
+        class scratch_arena
+        {
+        public:
+            scratch_arena();
+            ~scratch_arena();
+            scratch_arena(const scratch_arena &) = delete;
+            scratch_arena &operator=(const scratch_arena &) = delete;
+
+            void *allocate(std::size_t bytes);
+            void deallocate(void *p);
+            // free the chunks. only valid while no block is in use
+            void release();
+
+        private:
+            // blocks are whole units, each after a one unit header
+            static const std::size_t unit = alignof(std::max_align_t);
+
+            struct header
+            {
+                // offset of the block below this one in the chunk
+                std::size_t prev;
+                bool freed;
+            };
+
+            struct chunk
+            {
+                unsigned char *mem;
+                // size, units in use and offset of the top block, in units
+                std::size_t units, top, last;
+            };
+
+            std::vector<chunk> chunks;
+            std::size_t cur;
+        };
+
+        // the arena of the calling thread
+        scratch_arena &scratch();
+
+        // the resource set by set_scratch_resource, and the size from which
+        // temporaries are allocated from it
+        struct scratch_spill
+        {
+            memory_resource *resource = nullptr;
+            std::size_t bytes = 0;
+        };
+
+        scratch_spill &spill_config();
+
+        // allocator over the scratch arena of the calling thread. memory from
+        // it must be freed on the thread that allocated it
+        template <typename T>
+        struct scratch_allocator
+        {
+            typedef T value_type;
+
+            scratch_allocator() {}
+            template <typename U>
+            scratch_allocator(const scratch_allocator<U> &) {}
+
+            T *allocate(std::size_t n);
+            void deallocate(T *p, std::size_t n);
+        };
+
+        template <typename T, typename U>
+        bool operator==(const scratch_allocator<T> &, const scratch_allocator<U> &);
+        template <typename T, typename U>
+        bool operator!=(const scratch_allocator<T> &, const scratch_allocator<U> &);
+
+        // vectors for temporaries, allocated from the scratch arena
+        template <typename T>
+        using scratch_array = std::vector<T, scratch_allocator<T>>;
+        typedef scratch_array<limb_t> scratch_vector;
+
+        // a work stealing pool of threads for the parts of large products.
+        // every thread has its own queue, runs the newest task it queued
+        // first and steals the oldest one of another queue when it has none.
+        // a thread waiting for a group runs queued tasks meanwhile, so tasks
+        // may start and wait for tasks of their own. scratch memory is per
+        // thread, so a task must free the scratch memory it allocates and
+        // write its results to memory the caller allocated
+        class thread_pool
+        {
+        public:
+            // a set of tasks that is waited for together
+            class group
+            {
+            public:
+                group();
+
+            private:
+                friend class thread_pool;
+
+                // the tasks not yet finished
+                std::atomic<std::size_t> left;
+                // the first exception a task threw
+                std::mutex lock;
+                std::exception_ptr error;
+            };
+
+            // a pool of threads - 1 workers. the thread that waits is the last
+            explicit thread_pool(std::size_t threads);
+            ~thread_pool();
+
+            // the number of threads, the waiting one included
+            std::size_t size() const;
+            // queue f as a task of g
+            void run(group &g, std::function<void()> f);
+            // run queued tasks until every task of g has finished, then
+            // rethrow the first exception one threw
+            void wait(group &g);
+
+        private:
+            struct task
+            {
+                std::function<void()> f;
+                group *g;
+            };
+
+            struct queue
+            {
+                std::mutex lock;
+                std::deque<task> tasks;
+            };
+
+            // the pool and queue of the calling thread, if it is a worker
+            struct worker
+            {
+                const thread_pool *pool;
+                std::size_t index;
+            };
+            static worker &current();
+
+            // the queue of the calling thread. threads outside the pool share
+            // the last one
+            std::size_t own_queue() const;
+            // run one queued task, looking in queue self first. returns false
+            // if there was none
+            bool run_one(std::size_t self);
+            // the loop of worker self
+            void work(std::size_t self);
+
+            std::vector<std::unique_ptr<queue>> queues;
+            std::vector<std::thread> workers;
+            // the number of queued tasks, that idle workers sleep on
+            std::atomic<std::size_t> pending;
+            std::mutex sleep;
+            std::condition_variable wake;
+            bool stop;
+        };
+
+        // the pool products run on, made on first use and whenever the
+        // thread count changes
+        thread_pool &pool();
+        // the thread count setting, 0 for the hardware thread count
+        std::size_t &thread_config();
+        // the thread count setting, resolved
+        std::size_t thread_count();
+        // true while the calling thread must run products serially
+        bool &serial_scope();
+        // whether a product with operands of at least m limbs should run
+        // its parts on the pool
+        bool use_parallel(std::size_t m);
+        // call f(lo, hi) on chunks of [0, n) of at least grain elements, as
+        // tasks on the pool if parallel is set
+        template <typename F>
+        void parallel_for(bool parallel, std::size_t n, std::size_t grain, F f);
+
+        // the low level kernels below work on raw limb arrays, least
+        // significant limb first. unless stated otherwise r may be equal to a
+        // (in place) but must not partially overlap it
+
+        // add_n, sub_n, mul_1, addmul_1 and submul_1 call through the table
+        // of the kernels in use, chosen once from cpuid
+        struct kernel_table
+        {
+            limb_kernels set;
+            limb_t (*add_n)(limb_t *, const limb_t *, const limb_t *, std::size_t);
+            limb_t (*sub_n)(limb_t *, const limb_t *, const limb_t *, std::size_t);
+            limb_t (*mul_1)(limb_t *, const limb_t *, std::size_t, limb_t);
+            limb_t (*addmul_1)(limb_t *, const limb_t *, std::size_t, limb_t);
+            limb_t (*submul_1)(limb_t *, const limb_t *, std::size_t, limb_t);
+        };
+
+        // the kernels in use
+        kernel_table &kernel_config();
+        // the kernels of the set k, or the portable ones if k is not available
+        kernel_table make_kernels(limb_kernels k);
+        // whether the cpu has the adx and bmi2 extensions
+        bool cpu_adx();
+
+        // r = a + b, where a and b are both n limbs. returns the carry
+        limb_t add_n(limb_t *r, const limb_t *a, const limb_t *b, std::size_t n);
+        // r = a + b, where a is n limbs and b is a single limb. returns the carry
+        limb_t add_1(limb_t *r, const limb_t *a, std::size_t n, limb_t b);
+        // r = a - b, where a and b are both n limbs. returns the borrow
+        limb_t sub_n(limb_t *r, const limb_t *a, const limb_t *b, std::size_t n);
+        // r = a - b, where a is n limbs and b is a single limb. returns the borrow
+        limb_t sub_1(limb_t *r, const limb_t *a, std::size_t n, limb_t b);
+        // r = a * b, where a is n limbs and b is a single limb. returns the high limb
+        limb_t mul_1(limb_t *r, const limb_t *a, std::size_t n, limb_t b);
+        // r += a * b, where r and a are n limbs. returns the high limb
+        limb_t addmul_1(limb_t *r, const limb_t *a, std::size_t n, limb_t b);
+        // r -= a * b, where r and a are n limbs. returns the high limb to be borrowed
+        limb_t submul_1(limb_t *r, const limb_t *a, std::size_t n, limb_t b);
+        // compare a and b, both n limbs. returns -1, 0 or 1
+        int cmp_n(const limb_t *a, const limb_t *b, std::size_t n);
+
+        // the portable kernels, in plain c++
+        limb_t add_n_portable(limb_t *r, const limb_t *a, const limb_t *b, std::size_t n);
+        limb_t sub_n_portable(limb_t *r, const limb_t *a, const limb_t *b, std::size_t n);
+        limb_t mul_1_portable(limb_t *r, const limb_t *a, std::size_t n, limb_t b);
+        limb_t addmul_1_portable(limb_t *r, const limb_t *a, std::size_t n, limb_t b);
+        limb_t submul_1_portable(limb_t *r, const limb_t *a, std::size_t n, limb_t b);
+
+    #if defined(__SIZEOF_INT128__) && defined(__x86_64__) && defined(__GNUC__)
+        // the kernels on adx and bmi2, which must only run on a cpu that has
+        // them. add_n and sub_n chain _addcarry_u64 and _subborrow_u64. the
+        // products run two carry chains at once, adcx on the carry flag and
+        // adox on the overflow flag, which compilers do not keep apart when
+        // given the intrinsics, so their loops are in assembly
+        limb_t add_n_adx(limb_t *r, const limb_t *a, const limb_t *b, std::size_t n);
+        limb_t sub_n_adx(limb_t *r, const limb_t *a, const limb_t *b, std::size_t n);
+        limb_t mul_1_adx(limb_t *r, const limb_t *a, std::size_t n, limb_t b);
+        limb_t addmul_1_adx(limb_t *r, const limb_t *a, std::size_t n, limb_t b);
+        limb_t submul_1_adx(limb_t *r, const limb_t *a, std::size_t n, limb_t b);
+    #endif
+        // r = a << s for 0 < s < limb_bits. returns the bits shifted out. r >= a may overlap
+        limb_t lshift(limb_t *r, const limb_t *a, std::size_t n, int s);
+        // r = a >> s for 0 < s < limb_bits. returns the bits shifted out. r <= a may overlap
+        limb_t rshift(limb_t *r, const limb_t *a, std::size_t n, int s);
+        // q = a / d, where a is n limbs and d is a single non zero limb. returns
+        // a % d. q may be null to only find the remainder
+        limb_t divrem_1(limb_t *q, const limb_t *a, std::size_t n, limb_t d);
+        // q = a / d, where a is n limbs and d is a single limb known to divide a
+        void divexact_1(limb_t *q, const limb_t *a, std::size_t n, limb_t d);
+        // r = a * b, where a is n limbs, b is m limbs and r is n + m limbs.
+        // r must not overlap a or b
+        void mul_basecase(limb_t *r, const limb_t *a, std::size_t n, const limb_t *b, std::size_t m);
+        // r = a * a, where a is n limbs and r is 2n limbs. forms each cross
+        // product once, so it is nearly twice as fast as mul_basecase.
+        // r must not overlap a
+        void sqr_basecase(limb_t *r, const limb_t *a, std::size_t n);
+        // return the number of limbs in a after removing leading zero limbs
+        std::size_t normalized_size(const limb_t *a, std::size_t n);
+        // number of leading zero bits in a non zero limb
+        int count_leading_zeros(limb_t x);
+        // q = a / d and r = a % d, where a is n limbs, d is m >= 2 limbs with a
+        // non zero top limb, and n >= m. q is n - m + 1 limbs and r is m limbs.
+        // picks schoolbook or newton division from the operand sizes.
+        // q and r must not overlap a or d
+        void divrem(limb_t *q, limb_t *r, const limb_t *a, std::size_t n, const limb_t *d, std::size_t m);
+        // divrem by knuth's algorithm d
+        void divrem_knuth(limb_t *q, limb_t *r, const limb_t *a, std::size_t n, const limb_t *d, std::size_t m);
+        // divrem by multiplying with a newton iteration reciprocal of d
+        void divrem_newton(limb_t *q, limb_t *r, const limb_t *a, std::size_t n, const limb_t *d, std::size_t m);
+        // floor(B^2k / d) for a k limb d with its top bit set, or a few units
+        // below it, never above
+        scratch_vector reciprocal(const limb_t *d, std::size_t k);
+        // the thresholds currently in use
+        div_thresholds &div_config();
+        // the gcd thresholds currently in use
+        gcd_thresholds &gcd_config();
+
+        // r = a * b, where a is n limbs, b is m limbs and r is n + m limbs.
+        // picks schoolbook, karatsuba or toom-cook from the operand sizes.
+        // r must not overlap a or b
+        void mul(limb_t *r, const limb_t *a, std::size_t n, const limb_t *b, std::size_t m);
+        // mul, splitting the product into tasks for the thread pool if
+        // parallel is set. the plain mul sets it from the operand sizes
+        void mul(limb_t *r, const limb_t *a, std::size_t n, const limb_t *b, std::size_t m, bool parallel);
+        // r = a * b, where a and b are both n limbs and r is 2n limbs
+        void mul_n(limb_t *r, const limb_t *a, const limb_t *b, std::size_t n);
+        void mul_n(limb_t *r, const limb_t *a, const limb_t *b, std::size_t n, bool parallel);
+        // r = a * a, where a is n limbs and r is 2n limbs. r must not overlap a
+        void sqr(limb_t *r, const limb_t *a, std::size_t n);
+        // karatsuba multiplication of a and b, both n limbs
+        void mul_karatsuba(limb_t *r, const limb_t *a, const limb_t *b, std::size_t n, bool parallel);
+        // toom-k multiplication of a and b, both n limbs, splitting each into k parts
+        void mul_toom(limb_t *r, const limb_t *a, const limb_t *b, std::size_t n, int k, bool parallel);
+        // r += a * b, where a is n limbs, b is m limbs and r is rn >= n + m
+        // limbs. returns the carry out of r. r must not overlap a or b
+        limb_t addmul(limb_t *r, std::size_t rn, const limb_t *a, std::size_t n, const limb_t *b, std::size_t m);
+        // r -= a * b, as addmul. returns the borrow out of r
+        limb_t submul(limb_t *r, std::size_t rn, const limb_t *a, std::size_t n, const limb_t *b, std::size_t m);
+        // the thresholds currently in use
+        mul_thresholds &mul_config();
+
+        // numbers at most this many limbs long are converted to and from
+        // decimal one limb at a time, longer ones are split in half
+        const std::size_t dec_basecase = 40;
+        // 10^(dec_digits 2^i), computed on first use and kept
+        const std::vector<limb_t> &dec_power(std::size_t i);
+        // write a, n limbs, as exactly digits decimal digits to out, padded
+        // with leading zeros. a must be below 10^digits
+        void to_decimal(char *out, std::size_t digits, const limb_t *a, std::size_t n);
+        // read digits decimal digits from s, which must all be '0' to '9'
+        scratch_vector from_decimal(const char *s, std::size_t digits);
+        // the first character of [first, last) that is not a decimal digit,
+        // checking 32 characters at a time with avx2, 16 with sse2 and 8 in
+        // a word otherwise
+        const char *scan_digits(const char *first, const char *last);
+        // the value of the 8 decimal digits at s
+        std::uint32_t digits_8(const char *s);
+        // the value of the k decimal digits at s, for k at most dec_digits
+        limb_t digits_value(const char *s, int k);
+        // append the decimal digits at the front of in to s, taking them from
+        // the stream buffer a block at a time. sets eofbit if they run to the end
+        void get_digits(std::istream &in, std::string &s);
+
+    #if defined(__SIZEOF_INT128__)
+        // an ntt friendly prime p = c 2^k + 1 below 2^62, with the constants
+        // for montgomery multiplication modulo p (R = 2^64)
+        struct ntt_prime
+        {
+            std::uint64_t p;
+            // primitive root mod p
+            std::uint64_t g;
+            // -p^-1 mod R
+            std::uint64_t pinv;
+            // R^2 mod p
+            std::uint64_t r2;
+
+            ntt_prime(std::uint64_t p, std::uint64_t g);
+
+            // a b R^-1 mod p, for a b < p R
+            std::uint64_t mul(std::uint64_t a, std::uint64_t b) const;
+            // x in montgomery form, x R mod p
+            std::uint64_t to_mont(std::uint64_t x) const;
+            // a^e in montgomery form, for a in montgomery form
+            std::uint64_t pow(std::uint64_t a, std::uint64_t e) const;
+        };
+
+        // the three primes used for ntt multiplication. their product is
+        // above 2^183, so it can hold convolutions of up to 2^55 limbs
+        const ntt_prime &ntt_prime_at(int i);
+
+        // forward transform of n (a power of 2) values, leaving them in bit
+        // reversed order. roots[h + j] is w_2h^j in montgomery form. once the
+        // top level is done the two halves are independent transforms, which
+        // run as tasks on the thread pool if parallel is set
+        void ntt_forward(std::uint64_t *a, std::size_t n, const std::uint64_t *roots, const ntt_prime &q, bool parallel);
+        // inverse transform of n values from bit reversed order, without the 1/n
+        void ntt_inverse(std::uint64_t *a, std::size_t n, const std::uint64_t *roots, const ntt_prime &q, bool parallel);
+        // transforms and loops over at most this many values run on one thread
+        const std::size_t ntt_grain = 1 << 14;
+        // serial transforms over more values than this, 8 mb, go depth
+        // first: one level over all of them, then each half in turn. the
+        // levels below run on a block that stays in the outer caches, or in
+        // memory when the transform is in a mapped file, instead of
+        // streaming the whole array through once per level
+        const std::size_t ntt_block = 1 << 20;
+        // r = a * b with three prime ntt and crt recombination, where a is n
+        // limbs, b is m limbs and r is n + m limbs. r must not overlap a or b
+        void mul_ntt(limb_t *r, const limb_t *a, std::size_t n, const limb_t *b, std::size_t m, bool parallel);
+    #endif
+
+        // signed number, used for the intermediate values of toom-cook
+        struct signed_limbs
+        {
+            scratch_vector mag;
+            bool neg = false;
+        };
+
+        // a += b
+        void signed_add(signed_limbs &a, const signed_limbs &b);
+        // a -= b
+        void signed_sub(signed_limbs &a, const signed_limbs &b);
+        // a *= x
+        void signed_mul_1(signed_limbs &a, long long x);
+        // a /= x, where x is known to divide a
+        void signed_divexact_1(signed_limbs &a, long long x);
+
+        // limb storage for ubint, a vector that keeps up to inline_limbs
+        // limbs inside the object and only moves to the heap when it grows
+        // past them
+        class limb_vector
+        {
+        public:
+            static const std::size_t inline_limbs = 4;
+
+            // allocates from the current get_memory_resource()
+            limb_vector();
+            explicit limb_vector(memory_resource *r);
+            // copies allocate from the resource of v
+            limb_vector(const limb_vector &v);
+            // takes the heap buffer and resource of v, or copies its inline limbs
+            limb_vector(limb_vector &&v) noexcept;
+            ~limb_vector();
+            limb_vector &operator=(const limb_vector &v);
+            // takes the buffer of v if it comes from the same resource, and
+            // copies it otherwise, so it may throw
+            limb_vector &operator=(limb_vector &&v);
+
+            std::size_t size() const;
+            bool empty() const;
+            limb_t *data();
+            const limb_t *data() const;
+            limb_t &operator[](std::size_t i);
+            const limb_t &operator[](std::size_t i) const;
+            limb_t &back();
+            const limb_t &back() const;
+
+            // make room for n limbs without changing the size
+            void reserve(std::size_t n);
+            // change the size to n, setting any new limbs to x
+            void resize(std::size_t n, limb_t x = 0);
+            // change the size to n, leaving any new limbs unset for the
+            // caller to write, which saves a pass over large results
+            void resize_for_overwrite(std::size_t n);
+            void push_back(limb_t x);
+            void clear();
+            // replace the contents with the n limbs at a
+            void assign(const limb_t *a, std::size_t n);
+            // swaps the resources along with the limbs
+            void swap(limb_vector &v) noexcept;
+            // the resource the heap buffer comes from
+            memory_resource *resource() const;
+
+            friend bool operator==(const limb_vector &a, const limb_vector &b);
+
+        private:
+            // the limbs live in buf while cap is inline_limbs, and in heap
+            // once it is larger
+            union
+            {
+                limb_t buf[inline_limbs];
+                limb_t *heap;
+            } store;
+            std::size_t len, cap;
+            memory_resource *res;
+        };
+
+        // direct access to the limbs of a ubint, for the kernels in the
+        // headers built on top of it
+        struct ubint_access;
+    }
+
     // unsgined big integer
     class ubint
     {
     private:
 
-        // store each digit of the number as each byte (char) strung together
-        std::string digits;
+        // store the number as limbs (machine words) in base 2^limb_bits, least
+        // significant limb first. zero is stored as no limbs at all
+        detail::limb_vector limbs;
+
+        // remove the leading zero limbs
+        void trim();
+
+        // long division of a by b, writing the quotient to q and the
+        // remainder to r. either output may be null
+        static void divide(const ubint &a, const ubint &b, ubint *q, ubint *r);
+
+        // read b as a bit shift count. returns false if it does not fit
+        static bool shift_count(const ubint &b, std::size_t &count);
+
+        friend struct detail::ubint_access;
 
     public:
 
@@ -26,20 +657,35 @@ namespace estd
         ubint(const char * s);
         // copy constructor
         ubint(const ubint &u);
+        // move constructor, leaves u as zero
+        ubint(ubint &&u) noexcept;
+        // constructors allocating the limbs from r rather than the current
+        // get_memory_resource(). copies and moves keep the resource of the
+        // number they came from, while assignment keeps its own
+        ubint(unsigned long long n, memory_resource *r);
+        ubint(const std::string& s, memory_resource *r);
+        ubint(const char * s, memory_resource *r);
+        ubint(const ubint &u, memory_resource *r);
+
+        // the resource the limbs are allocated from
+        memory_resource *resource() const;
 
         // check if a ubint is null
         friend bool null(const ubint &);
-        // return the length of a ubint
+        // return the length of a ubint (number of decimal digits)
         friend int length(const ubint &);
 
         // member access
-        // [] operator overload
+        // [] operator overload (decimal digit, least significant first)
         int operator[](const int) const;
         // get the string value of the ubint
         std::string value() const;
 
         // direct assignment
         ubint &operator=(const ubint &);
+        // move assignment, leaves a as zero. the limbs of a number from
+        // another resource are copied, so it may throw
+        ubint &operator=(ubint &&a);
 
         // post/pre incrementation
         ubint &operator++();
@@ -52,8 +698,14 @@ namespace estd
         friend ubint &operator+=(ubint &, const ubint &);
         // addition
         friend ubint operator+(const ubint &, const ubint &);
+        // addition reusing an expiring operand
+        friend ubint operator+(ubint &&, const ubint &);
+        friend ubint operator+(const ubint &, ubint &&);
+        friend ubint operator+(ubint &&, ubint &&);
         // subtraction
         friend ubint operator-(const ubint &, const ubint &);
+        // subtraction reusing an expiring operand
+        friend ubint operator-(ubint &&, const ubint &);
         // subtraction to self
         friend ubint &operator-=(ubint &, const ubint &);
 
@@ -76,21 +728,51 @@ namespace estd
         friend ubint &operator*=(ubint &, const ubint &);
         // multiply
         friend ubint operator*(const ubint &, const ubint &);
+        // multiplication reusing an expiring operand
+        friend ubint operator*(ubint &&, const ubint &);
+        friend ubint operator*(const ubint &, ubint &&);
+        friend ubint operator*(ubint &&, ubint &&);
         // divide and assign
         friend ubint &operator/=(ubint &, const ubint &);
         // divide
         friend ubint operator/(const ubint &, const ubint &);
+        // division reusing an expiring operand
+        friend ubint operator/(ubint &&, const ubint &);
     
         // modulo
         friend ubint operator%(const ubint &, const ubint &);
+        // modulo reusing an expiring operand
+        friend ubint operator%(ubint &&, const ubint &);
         // modulo and assign
         friend ubint &operator%=(ubint &, const ubint &);
 
+        // quotient and remainder of a / b from a single division
+        friend std::pair<ubint, ubint> divmod(const ubint &a, const ubint &b);
+        // quotient and remainder of a / b from a single division, written
+        // to q and r. q and r may be a or b
+        friend void divmod(const ubint &a, const ubint &b, ubint &q, ubint &r);
+
+        // fused multiply and add, writing into r without a temporary for the
+        // product where the operands allow it. r may be any of the operands
+        // r = a * b + c
+        friend ubint &muladd(ubint &r, const ubint &a, const ubint &b, const ubint &c);
+        // r = a * b - c, throws if c is larger than a * b
+        friend ubint &mulsub(ubint &r, const ubint &a, const ubint &b, const ubint &c);
+        // r += a * b
+        friend ubint &addmul(ubint &r, const ubint &a, const ubint &b);
+        // r -= a * b, throws and leaves r unchanged if a * b is larger than r
+        friend ubint &submul(ubint &r, const ubint &a, const ubint &b);
+
         // bit shifts
         friend ubint operator<<(const ubint &, const ubint &);
         friend ubint &operator<<=(ubint &, const ubint &);
         friend ubint operator>>(const ubint &, const ubint &);
         friend ubint &operator>>=(ubint &, const ubint &);
+        // bit shifts by a machine word count
+        friend ubint operator<<(const ubint &, std::size_t);
+        friend ubint &operator<<=(ubint &, std::size_t);
+        friend ubint operator>>(const ubint &, std::size_t);
+        friend ubint &operator>>=(ubint &, std::size_t);
     
         // exponent
         // raise to power and assign
@@ -98,8 +780,25 @@ namespace estd
         // raise to power
         friend ubint operator^(const ubint &, const ubint &);
 
-        // square root
+        // roots and powers
+        // square root, rounded down
         friend ubint sqrt(const ubint &);
+        // square root rounded down and the remainder a - s^2
+        friend std::pair<ubint, ubint> sqrtrem(const ubint &a);
+        // square root and remainder written to s and r, which may be a
+        friend void sqrtrem(const ubint &a, ubint &s, ubint &r);
+        // k-th root, rounded down. throws if k is zero
+        friend ubint iroot(const ubint &a, std::size_t k);
+        // whether a is the square of a whole number
+        friend bool is_perfect_square(const ubint &a);
+        // whether a is b^k for a whole b and some k >= 2, which 0 and 1 are
+        friend bool is_perfect_power(const ubint &a);
+
+        // gcd and lcm
+        // greatest common divisor. gcd(a, 0) is a
+        friend ubint gcd(const ubint &a, const ubint &b);
+        // least common multiple, zero if a or b is
+        friend ubint lcm(const ubint &a, const ubint &b);
 
         // min, max
         // return the min of a and b
@@ -110,274 +809,3944 @@ namespace estd
         // read and write
         // witre to output stream
         friend std::ostream &operator<<(std::ostream &, const ubint &);
-        // read to input stream
+        // read to input stream. reads the digits up to the first other
+        // character, and sets failbit if there are none
         friend std::istream &operator>>(std::istream &, ubint &);
+        // read the decimal number at the start of [first, last) into a, as
+        // std::from_chars does for the built in types. returns the end of
+        // the digits, or first and invalid_argument if there are none, in
+        // which case a is left as it was. it has no range errors, and only
+        // throws if memory runs out
+        friend std::from_chars_result from_chars(const char *first, const char *last, ubint &a);
 
-        // return n!
+        // return n!, throws if n does not fit a machine word
         friend ubint factorial(const ubint &n);
         // maps ubint x from range (a, b) to (c, d)
         friend ubint map(const ubint &x, const ubint &a, const ubint &b, const ubint &c, const ubint &d);
     };
 
-    ubint::ubint(unsigned long long n)
-    {
-        do {
-            digits.push_back(n % 10);
-            n /= 10;
-        } while (n);
-    }
+    // n!, from the prime factorization of n! multiplied out as a balanced
+    // product tree
+    ubint factorial(std::uint64_t n);
+    // n choose k, zero if k is larger than n
+    ubint binomial(std::uint64_t n, std::uint64_t k);
+    // the product of the primes up to n
+    ubint primorial(std::uint64_t n);
 
-    ubint::ubint(const std::string& s)
+    namespace detail
     {
-        digits = "";
-        for (int i = s.size() - 1; i >= 0; i--)
+        struct ubint_access
         {
-            if (!isdigit(s[i]))
-            {
-                throw std::invalid_argument("input must be a number");
-            }
+            // the limbs of a, least significant first, with no leading zero limbs
+            static limb_vector &limbs(ubint &a);
+            static const limb_vector &limbs(const ubint &a);
+            // remove leading zero limbs after writing to the limbs of a
+            static void trim(ubint &a);
+        };
 
-            digits.push_back(s[i] - '0');
-        }
-    }
+        // the primes up to n, in increasing order
+        std::vector<std::uint64_t> primes_upto(std::uint64_t n);
+        // the exponent of the prime p in n!, by legendre's formula
+        std::uint64_t legendre(std::uint64_t n, std::uint64_t p);
+        // the product of the n numbers at v. neighbours are packed into limbs
+        // and then multiplied out as a balanced tree, so the large products
+        // get operands of about the same size
+        ubint product(const std::uint64_t *v, std::size_t n);
+        // the product of the n packed values at v, with the subtrees of a
+        // large product run on the pool
+        ubint product_tree(const std::uint64_t *v, std::size_t n);
+        // the product of p[i]^e[i], from the highest exponent bit down:
+        // square, then multiply in the primes whose exponents have that bit
+        ubint prime_power_product(const std::vector<std::uint64_t> &p, const std::vector<std::uint64_t> &e);
 
-    ubint::ubint(const char * s) : ubint(std::string(s)) {}
+        // the number of bits in a, zero for zero
+        std::size_t bit_length(const ubint &a);
+        // the number of zero bits below the lowest set bit of a non zero a
+        std::size_t trailing_zeros(const ubint &a);
+        // log2 of a non zero a, to double precision
+        double log2_approx(const ubint &a);
+        // x^e, by binary powering from the top bit of e
+        ubint pow_ui(const ubint &x, std::uint64_t e);
+        // 10^k. the last power asked for is kept per thread, so a loop over
+        // the digits of a number, or repeated lengths, only compute it once
+        const ubint &pow10(std::size_t k);
+        // a = a mod 2^k
+        void truncate(ubint &a, std::size_t k);
+        // false if a cannot be a square, from a mod 64 and a mod small odd
+        // moduli. true for every square
+        bool square_candidate(const ubint &a);
+        // the x < 2^k with x^p = a mod 2^k, for an odd a and an odd p. if a is
+        // a p-th power with a root below 2^k this is the root
+        ubint root_2adic(const ubint &a, std::uint64_t p, std::size_t k);
 
-    ubint::ubint(const ubint &u)
-    {
-        digits = u.digits;
-    }
+        // the matrix of a run of euclid steps, taking the reduced pair back
+        // to the pair it came from: (a, b) = m (a', b'). each step adds a
+        // multiple of one column to the other, so the determinant is 1 and
+        // the entries are never negative
+        struct gcd_matrix
+        {
+            // the identity
+            gcd_matrix();
 
-    std::ostream &operator<<(std::ostream &out, const ubint &a)
-    {
-        for (int i = a.digits.size() - 1; i >= 0; i--)
+            ubint u[2][2];
+        };
+
+        // a gcd_matrix with single limb entries
+        struct gcd_matrix1
+        {
+            // the identity
+            gcd_matrix1();
+
+            limb_t u[2][2];
+        };
+
+        // gcd of non zero a and b, by the binary algorithm
+        limb_t gcd_1(limb_t a, limb_t b);
+        dlimb_t gcd_2(dlimb_t a, dlimb_t b);
+        // the top two limbs of a and b, both at most n limbs, shifted left
+        // until one of them has its top bit set
+        void gcd_top(const ubint &a, const ubint &b, std::size_t n, dlimb_t &x, dlimb_t &y);
+        // lehmer's step: the euclid steps on x and y, the top two limbs of a
+        // and b, that are sure to be steps of a and b too, stopping while
+        // both remainders are above two limbs. false if there are none
+        bool hgcd2(dlimb_t x, dlimb_t y, gcd_matrix1 &m);
+        // (a, b) = m^-1 (a, b)
+        void gcd_apply(const gcd_matrix1 &m, ubint &a, ubint &b);
+        // m = m m1
+        void gcd_mul(gcd_matrix &m, const gcd_matrix1 &m1);
+        void gcd_mul(gcd_matrix &m, const gcd_matrix &m1);
+        // take q times the smaller of a and b from the larger, for the largest
+        // q that leaves it above s limbs, or for its quotient if s is 0, and
+        // multiply m by the step if it is given. false if there is no such q
+        bool gcd_divstep(ubint &a, ubint &b, std::size_t s, gcd_matrix *m);
+        // a lehmer step if the top limbs allow one and a division step
+        // otherwise, keeping both above s limbs. false if there is neither
+        bool hgcd_step(ubint &a, ubint &b, std::size_t s, gcd_matrix &m);
+        // half gcd: reduce a and b, at most n limbs, by euclid steps while
+        // both stay above n / 2 + 1 limbs, setting m to the reduction, which
+        // must be the identity on entry. false if no step could be taken
+        bool hgcd(ubint &a, ubint &b, gcd_matrix &m);
+        // reduce a and b by the half gcd of their top limbs from limb p up,
+        // setting m to the reduction. false if it took no steps
+        bool hgcd_reduce(ubint &a, ubint &b, std::size_t p, gcd_matrix &m);
+        // reduce a and b until one of them is zero and the other is their
+        // gcd, multiplying m by the steps if it is given
+        void gcd_reduce(ubint &a, ubint &b, gcd_matrix *m);
+        // g = gcd(a, b) and s, t with g = s a - t b, or with g = t b - s a if
+        // swapped is set. s <= b / g and t <= a / g if a and b are non zero
+        ubint gcdext(const ubint &a, const ubint &b, ubint &s, ubint &t, bool &swapped);
+
+        limb_vector &ubint_access::limbs(ubint &a)
         {
-            out << (short)a.digits[i];
+            return a.limbs;
         }
 
-        return out;
-    }
+        const limb_vector &ubint_access::limbs(const ubint &a)
+        {
+            return a.limbs;
+        }
 
-    std::istream &operator>>(std::istream &in, ubint &a)
-    {
-        std::string s;
-        in >> s;
-        int n = s.size();
+        void ubint_access::trim(ubint &a)
+        {
+            a.trim();
+        }
+
+        scratch_arena::scratch_arena() : cur(0) {}
 
-        for (int i = n - 1; i >= 0; i--)
+        scratch_arena::~scratch_arena()
         {
-            if (!isdigit(s[i]))
+            for (std::size_t i = 0; i < chunks.size(); i++)
             {
-                throw std::invalid_argument("input must be a number");
+                ::operator delete(chunks[i].mem);
             }
-            a.digits[n - i - 1] = s[i];
         }
 
-        return in;
-    }
+        void *scratch_arena::allocate(std::size_t bytes)
+        {
+            std::size_t units = (bytes + unit - 1) / unit + 1;
+            if (chunks.empty() || chunks[cur].top + units > chunks[cur].units)
+            {
+                // move on to the next chunk. a next chunk that is too small is
+                // dropped along with the ones after it, and a larger one made
+                std::size_t next = chunks.empty() ? 0 : cur + 1;
+                if (next < chunks.size() && chunks[next].units < units)
+                {
+                    for (std::size_t i = next; i < chunks.size(); i++)
+                    {
+                        ::operator delete(chunks[i].mem);
+                    }
+                    chunks.resize(next);
+                }
 
-    bool null(const ubint &a)
-    {
-        return (a.digits.size() == 1 && a.digits[0] == 0);
-    }
+                if (next == chunks.size())
+                {
+                    std::size_t size = std::max<std::size_t>(units, 4096);
+                    if (!chunks.empty())
+                    {
+                        size = std::max(size, 2 * chunks.back().units);
+                    }
 
-    int length(const ubint &a)
-    {
-        return a.digits.size();
-    }
+                    chunk c;
+                    c.mem = static_cast<unsigned char *>(::operator new(size * unit));
+                    c.units = size;
+                    c.top = 0;
+                    c.last = 0;
+                    chunks.push_back(c);
+                }
 
-    int ubint::operator[](const int index) const
-    {
-        if (digits.size() <= index || index < 0)
-        {
-            throw std::out_of_range("index out of range");
-        }
+                cur = next;
+            }
 
-        return digits[index];
-    }
+            chunk &c = chunks[cur];
+            header *h = reinterpret_cast<header *>(c.mem + c.top * unit);
+            h->prev = c.last;
+            h->freed = false;
+            c.last = c.top;
+            c.top += units;
 
-    std::string ubint::value() const
-    {
-        std::string val;
-        for (int i = 0; i < digits.size(); i++)
-        {
-            val.insert(0, std::to_string(digits[i]));
+            return reinterpret_cast<unsigned char *>(h) + unit;
         }
 
-        return val;
-    }
+        void scratch_arena::deallocate(void *p)
+        {
+            reinterpret_cast<header *>(static_cast<unsigned char *>(p) - unit)->freed = true;
 
-    ubint &ubint::operator=(const ubint &a)
-    {
-        digits = a.digits;
-        return (*this);
-    }
+            // reclaim freed blocks from the top, stepping back a chunk when one
+            // empties
+            while (true)
+            {
+                chunk &c = chunks[cur];
+                if (!c.top)
+                {
+                    if (!cur)
+                    {
+                        break;
+                    }
 
-    ubint &ubint::operator++()
-    {
-        int i, n = digits.size();
+                    cur--;
+                    continue;
+                }
 
-        for (i = 0; i < n && digits[i] == 9; i++)
-        {
-            digits[i] = 0;
+                header *h = reinterpret_cast<header *>(c.mem + c.last * unit);
+                if (!h->freed)
+                {
+                    break;
+                }
+
+                c.top = c.last;
+                c.last = h->prev;
+            }
         }
 
-        if (i == n)
+        void scratch_arena::release()
         {
-            digits.push_back(1);
+            if (chunks.empty() || cur || chunks[0].top)
+            {
+                return;
+            }
+
+            for (std::size_t i = 0; i < chunks.size(); i++)
+            {
+                ::operator delete(chunks[i].mem);
+            }
+            chunks.clear();
         }
-        else
+
+        scratch_arena &scratch()
         {
-            digits[i]++;
+            static thread_local scratch_arena arena;
+            return arena;
         }
 
-        return (*this);
-    }
+        template <typename T>
+        T *scratch_allocator<T>::allocate(std::size_t n)
+        {
+            const scratch_spill &s = spill_config();
+            if (s.resource && n * sizeof(T) >= s.bytes)
+            {
+                return static_cast<T *>(s.resource->allocate(n * sizeof(T), alignof(T)));
+            }
 
-    ubint ubint::operator++(int temp)
-    {
-        ubint result = *this;
+            return static_cast<T *>(scratch().allocate(n * sizeof(T)));
+        }
 
-        if (temp != 0)
+        template <typename T>
+        void scratch_allocator<T>::deallocate(T *p, std::size_t n)
         {
-            (*this) += temp;
-        } else {
-            ++(*this);
-        }
+            const scratch_spill &s = spill_config();
+            if (s.resource && n * sizeof(T) >= s.bytes)
+            {
+                s.resource->deallocate(p, n * sizeof(T), alignof(T));
+                return;
+            }
 
-        return result;
-    }
+            scratch().deallocate(p);
+        }
 
-    ubint &ubint::operator--()
-    {
-        if (null(*this))
+        template <typename T, typename U>
+        bool operator==(const scratch_allocator<T> &, const scratch_allocator<U> &)
         {
-            throw std::underflow_error("underflow");
+            return true;
         }
 
-        int i, n = digits.size();
-        for (i = 0; i < n && digits[i] == 0; i++)
+        template <typename T, typename U>
+        bool operator!=(const scratch_allocator<T> &, const scratch_allocator<U> &)
         {
-            digits[i] = 9;
+            return false;
         }
 
-        digits[i]--;
-        if (n > 1 && digits[n - 1] == 0)
+    #if !defined(__cpp_lib_memory_resource)
+        // plain new and delete, the default resource
+        class new_delete_resource : public memory_resource
         {
-            digits.pop_back();
-        }
+        private:
+            void *do_allocate(std::size_t bytes, std::size_t)
+            {
+                return ::operator new(bytes);
+            }
 
-        return *this;
-    }
+            void do_deallocate(void *p, std::size_t, std::size_t)
+            {
+                ::operator delete(p);
+            }
 
-    ubint ubint::operator--(int temp)
-    {
-        ubint result = *this;
+            bool do_is_equal(const memory_resource &other) const noexcept
+            {
+                return this == &other;
+            }
+        };
+    #endif
 
-        if (temp != 0)
+        // new and delete as a resource
+        memory_resource *default_resource()
         {
-            (*this) -= temp;
-        } else {
-            --(*this);
+        #if defined(__cpp_lib_memory_resource)
+            return std::pmr::new_delete_resource();
+        #else
+            static new_delete_resource r;
+            return &r;
+        #endif
         }
 
-        return result;
-    }
-
-    ubint &operator+=(ubint &a, const ubint &b)
-    {
-        // t = carry, s = sum, i = index, n = length(a), m = length(b)
-        int t = 0, s, i;
-        int n = length(a), m = length(b);
+        // the resource new numbers allocate from
+        memory_resource *&resource_config()
+        {
+            static memory_resource *config = default_resource();
+            return config;
+        }
 
-        if (m > n)
+        scratch_spill &spill_config()
         {
-            a.digits.append(m - n, 0);
-            n = length(a);
+            static scratch_spill config;
+            return config;
         }
 
-        for (i = 0; i < n; i++)
+        thread_pool::group::group() : left(0) {}
+
+        thread_pool::thread_pool(std::size_t threads) : pending(0), stop(false)
         {
-            if (i < m)
+            threads = std::max<std::size_t>(threads, 1);
+            for (std::size_t i = 0; i < threads; i++)
             {
-                s = (a.digits[i] + b.digits[i]) + t;
+                queues.emplace_back(new queue());
             }
-            else
+            for (std::size_t i = 0; i + 1 < threads; i++)
             {
-                s = (a.digits[i]) + t;
+                workers.emplace_back(&thread_pool::work, this, i);
             }
-            t = s / 10;
-            a.digits[i] = (s % 10);
         }
 
-        if (t)
+        thread_pool::~thread_pool()
         {
-            a.digits.push_back(t);
-        }
-
-        return a;
-    }
-
-    ubint operator+(const ubint &a, const ubint &b)
-    {
-        ubint tmp = a;
-        tmp += b;
-        return tmp;
-    }
+            {
+                std::lock_guard<std::mutex> guard(sleep);
+                stop = true;
+            }
+            wake.notify_all();
 
-    ubint operator-(const ubint &a, const ubint &b)
-    {
-        ubint tmp = a;
-        tmp -= b;
-        return tmp;
-    }
+            for (std::size_t i = 0; i < workers.size(); i++)
+            {
+                workers[i].join();
+            }
+        }
 
-    ubint &operator-=(ubint &a, const ubint &b)
-    {
-        if (a < b)
+        std::size_t thread_pool::size() const
         {
-            throw std::underflow_error("underflow. a cannot be less than b");
+            return queues.size();
         }
 
-        int n = length(a), m = length(b);
-        int i, t = 0, s;
-
-        for (i = 0; i < n; i++)
+        void thread_pool::run(group &g, std::function<void()> f)
         {
-            if (i < m)
+            g.left++;
+            queue &q = *queues[own_queue()];
             {
-                s = (a.digits[i] - b.digits[i]) + t;
+                std::lock_guard<std::mutex> guard(q.lock);
+                q.tasks.push_back(task{std::move(f), &g});
             }
-            else
+
             {
-                s = a.digits[i] + t;
+                std::lock_guard<std::mutex> guard(sleep);
+                pending++;
             }
+            wake.notify_one();
+        }
 
-            if (s < 0)
+        void thread_pool::wait(group &g)
+        {
+            std::size_t self = own_queue();
+            while (g.left.load())
             {
-                s += 10;
-                t = -1;
+                // the tasks left are running on other threads
+                if (!run_one(self))
+                {
+                    std::this_thread::yield();
+                }
             }
-            else
+
+            if (g.error)
             {
-                t = 0;
+                std::exception_ptr error = g.error;
+                g.error = nullptr;
+                std::rethrow_exception(error);
             }
+        }
 
-            a.digits[i] = s;
+        thread_pool::worker &thread_pool::current()
+        {
+            static thread_local worker w = {nullptr, 0};
+            return w;
         }
 
-        while (n > 1 && a.digits[n - 1] == 0)
+        std::size_t thread_pool::own_queue() const
         {
-            a.digits.pop_back();
-            n--;
+            const worker &w = current();
+            return (w.pool == this) ? w.index : queues.size() - 1;
         }
 
-        return a;
-    }
+        bool thread_pool::run_one(std::size_t self)
+        {
+            task t;
+            bool found = false;
+            for (std::size_t i = 0; i < queues.size() && !found; i++)
+            {
+                queue &q = *queues[(self + i) % queues.size()];
+                std::lock_guard<std::mutex> guard(q.lock);
+                if (!q.tasks.empty())
+                {
+                    // newest first from our own queue, so the tasks that are
+                    // still hot in cache run first, oldest first from others
+                    if (i == 0)
+                    {
+                        t = std::move(q.tasks.back());
+                        q.tasks.pop_back();
+                    }
+                    else
+                    {
+                        t = std::move(q.tasks.front());
+                        q.tasks.pop_front();
+                    }
+                    found = true;
+                }
+            }
+
+            if (!found)
+            {
+                return false;
+            }
+            pending--;
+
+            try
+            {
+                t.f();
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> guard(t.g->lock);
+                if (!t.g->error)
+                {
+                    t.g->error = std::current_exception();
+                }
+            }
+
+            // the waiter may destroy the group as soon as this drops to zero
+            t.g->left--;
+            return true;
+        }
+
+        void thread_pool::work(std::size_t self)
+        {
+            current().pool = this;
+            current().index = self;
+
+            for (;;)
+            {
+                if (run_one(self))
+                {
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> guard(sleep);
+                wake.wait(guard, [this] { return stop || pending.load(); });
+                if (stop)
+                {
+                    return;
+                }
+            }
+        }
+
+        thread_pool &pool()
+        {
+            static std::mutex lock;
+            static std::unique_ptr<thread_pool> instance;
+
+            std::lock_guard<std::mutex> guard(lock);
+            std::size_t threads = thread_count();
+            if (!instance || instance->size() != threads)
+            {
+                instance.reset(new thread_pool(threads));
+            }
+            return *instance;
+        }
+
+        std::size_t &thread_config()
+        {
+            static std::size_t config = 0;
+            return config;
+        }
+
+        std::size_t thread_count()
+        {
+            static const std::size_t hardware = std::thread::hardware_concurrency();
+            std::size_t n = thread_config() ? thread_config() : hardware;
+            return std::max<std::size_t>(n, 1);
+        }
+
+        bool &serial_scope()
+        {
+            static thread_local bool serial = false;
+            return serial;
+        }
+
+        bool use_parallel(std::size_t m)
+        {
+            return m >= mul_config().parallel && !serial_scope() && thread_count() > 1;
+        }
+
+        template <typename F>
+        void parallel_for(bool parallel, std::size_t n, std::size_t grain, F f)
+        {
+            std::size_t chunks = 1;
+            if (parallel && n >= 2 * grain)
+            {
+                chunks = std::min(n / grain, 4 * thread_count());
+            }
+            if (chunks <= 1)
+            {
+                f(std::size_t(0), n);
+                return;
+            }
+
+            // every chunk is a task, as the waiting thread runs them too
+            thread_pool &tp = pool();
+            thread_pool::group g;
+            std::size_t step = (n + chunks - 1) / chunks;
+            for (std::size_t lo = 0; lo < n; lo += step)
+            {
+                std::size_t hi = std::min(n, lo + step);
+                tp.run(g, [&f, lo, hi] { f(lo, hi); });
+            }
+            tp.wait(g);
+        }
+
+        kernel_table &kernel_config()
+        {
+            static kernel_table config = make_kernels(limb_kernels::adx);
+            return config;
+        }
+
+        kernel_table make_kernels(limb_kernels k)
+        {
+        #if defined(__SIZEOF_INT128__) && defined(__x86_64__) && defined(__GNUC__)
+            if (k == limb_kernels::adx && cpu_adx())
+            {
+                return {limb_kernels::adx, add_n_adx, sub_n_adx, mul_1_adx, addmul_1_adx, submul_1_adx};
+            }
+        #endif
+            (void)k;
+            return {limb_kernels::portable, add_n_portable, sub_n_portable, mul_1_portable, addmul_1_portable, submul_1_portable};
+        }
+
+        bool cpu_adx()
+        {
+        #if defined(__SIZEOF_INT128__) && defined(__x86_64__) && defined(__GNUC__)
+            // leaf 7 reports bmi2 in bit 8 of ebx and adx in bit 19
+            unsigned int a, b, c, d;
+            return __get_cpuid_count(7, 0, &a, &b, &c, &d) && (b >> 8 & 1) && (b >> 19 & 1);
+        #else
+            return false;
+        #endif
+        }
+
+        limb_t add_n(limb_t *r, const limb_t *a, const limb_t *b, std::size_t n)
+        {
+            return kernel_config().add_n(r, a, b, n);
+        }
+
+        limb_t sub_n(limb_t *r, const limb_t *a, const limb_t *b, std::size_t n)
+        {
+            return kernel_config().sub_n(r, a, b, n);
+        }
+
+        limb_t mul_1(limb_t *r, const limb_t *a, std::size_t n, limb_t b)
+        {
+            return kernel_config().mul_1(r, a, n, b);
+        }
+
+        limb_t addmul_1(limb_t *r, const limb_t *a, std::size_t n, limb_t b)
+        {
+            return kernel_config().addmul_1(r, a, n, b);
+        }
+
+        limb_t submul_1(limb_t *r, const limb_t *a, std::size_t n, limb_t b)
+        {
+            return kernel_config().submul_1(r, a, n, b);
+        }
+
+        limb_t add_n_portable(limb_t *r, const limb_t *a, const limb_t *b, std::size_t n)
+        {
+            limb_t c = 0;
+            for (std::size_t i = 0; i < n; i++)
+            {
+                limb_t s = a[i] + c;
+                c = (s < c);
+                limb_t t = s + b[i];
+                c += (t < s);
+                r[i] = t;
+            }
+
+            return c;
+        }
+
+        limb_t add_1(limb_t *r, const limb_t *a, std::size_t n, limb_t b)
+        {
+            // the carry rarely goes far, the rest is only copied
+            std::size_t i = 0;
+            for (; i < n && b; i++)
+            {
+                limb_t s = a[i] + b;
+                b = (s < b);
+                r[i] = s;
+            }
+            if (r != a)
+            {
+                std::copy(a + i, a + n, r + i);
+            }
+
+            return b;
+        }
+
+        limb_t sub_n_portable(limb_t *r, const limb_t *a, const limb_t *b, std::size_t n)
+        {
+            limb_t c = 0;
+            for (std::size_t i = 0; i < n; i++)
+            {
+                limb_t d = a[i] - b[i];
+                limb_t t = d - c;
+                c = (a[i] < b[i]) + (d < c);
+                r[i] = t;
+            }
+
+            return c;
+        }
+
+        limb_t sub_1(limb_t *r, const limb_t *a, std::size_t n, limb_t b)
+        {
+            // the borrow rarely goes far, the rest is only copied
+            std::size_t i = 0;
+            for (; i < n && b; i++)
+            {
+                limb_t d = a[i] - b;
+                b = (a[i] < b);
+                r[i] = d;
+            }
+            if (r != a)
+            {
+                std::copy(a + i, a + n, r + i);
+            }
+
+            return b;
+        }
+
+        limb_t mul_1_portable(limb_t *r, const limb_t *a, std::size_t n, limb_t b)
+        {
+            limb_t c = 0;
+            for (std::size_t i = 0; i < n; i++)
+            {
+                dlimb_t t = (dlimb_t)a[i] * b + c;
+                r[i] = (limb_t)t;
+                c = (limb_t)(t >> limb_bits);
+            }
+
+            return c;
+        }
+
+        limb_t addmul_1_portable(limb_t *r, const limb_t *a, std::size_t n, limb_t b)
+        {
+            limb_t c = 0;
+            for (std::size_t i = 0; i < n; i++)
+            {
+                // (2^k - 1)^2 + 2 * (2^k - 1) fits in a double limb
+                dlimb_t t = (dlimb_t)a[i] * b + r[i] + c;
+                r[i] = (limb_t)t;
+                c = (limb_t)(t >> limb_bits);
+            }
+
+            return c;
+        }
+
+        limb_t submul_1_portable(limb_t *r, const limb_t *a, std::size_t n, limb_t b)
+        {
+            limb_t c = 0;
+            for (std::size_t i = 0; i < n; i++)
+            {
+                dlimb_t t = (dlimb_t)a[i] * b + c;
+                limb_t lo = (limb_t)t;
+                c = (limb_t)(t >> limb_bits);
+                c += (r[i] < lo);
+                r[i] -= lo;
+            }
+
+            return c;
+        }
+
+    #if defined(__SIZEOF_INT128__) && defined(__x86_64__) && defined(__GNUC__)
+        limb_t add_n_adx(limb_t *r, const limb_t *a, const limb_t *b, std::size_t n)
+        {
+            unsigned char c = 0;
+            unsigned long long t0, t1, t2, t3;
+            std::size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                c = _addcarry_u64(c, a[i], b[i], &t0);
+                c = _addcarry_u64(c, a[i + 1], b[i + 1], &t1);
+                c = _addcarry_u64(c, a[i + 2], b[i + 2], &t2);
+                c = _addcarry_u64(c, a[i + 3], b[i + 3], &t3);
+                r[i] = t0;
+                r[i + 1] = t1;
+                r[i + 2] = t2;
+                r[i + 3] = t3;
+            }
+            for (; i < n; i++)
+            {
+                c = _addcarry_u64(c, a[i], b[i], &t0);
+                r[i] = t0;
+            }
+
+            return c;
+        }
+
+        limb_t sub_n_adx(limb_t *r, const limb_t *a, const limb_t *b, std::size_t n)
+        {
+            unsigned char c = 0;
+            unsigned long long t0, t1, t2, t3;
+            std::size_t i = 0;
+            for (; i + 4 <= n; i += 4)
+            {
+                c = _subborrow_u64(c, a[i], b[i], &t0);
+                c = _subborrow_u64(c, a[i + 1], b[i + 1], &t1);
+                c = _subborrow_u64(c, a[i + 2], b[i + 2], &t2);
+                c = _subborrow_u64(c, a[i + 3], b[i + 3], &t3);
+                r[i] = t0;
+                r[i + 1] = t1;
+                r[i + 2] = t2;
+                r[i + 3] = t3;
+            }
+            for (; i < n; i++)
+            {
+                c = _subborrow_u64(c, a[i], b[i], &t0);
+                r[i] = t0;
+            }
+
+            return c;
+        }
+
+        // the loops below take the first n % 4 limbs in c++ and the rest
+        // four at a time. they count a negative index up to zero relative to
+        // the ends of the arrays in rcx, so that lea and jrcxz end the loop
+        // without touching the flags that carry between the limbs
+
+        limb_t mul_1_adx(limb_t *r, const limb_t *a, std::size_t n, limb_t b)
+        {
+            std::size_t m = n % 4;
+            limb_t h = mul_1_portable(r, a, m, b);
+            if (m == n)
+            {
+                return h;
+            }
+
+            std::ptrdiff_t i = (std::ptrdiff_t)m - (std::ptrdiff_t)n;
+            limb_t lo0, lo1, hi;
+            // r[i] = lo[i] + hi[i - 1] + cf
+            __asm__ volatile(
+                "xor %[lo0], %[lo0]\n\t"
+                "1:\n\t"
+                "mulx (%[a],%[i],8), %[lo0], %[hi]\n\t"
+                "adcx %[h], %[lo0]\n\t"
+                "mov %[lo0], (%[r],%[i],8)\n\t"
+                "mulx 8(%[a],%[i],8), %[lo1], %[h]\n\t"
+                "adcx %[hi], %[lo1]\n\t"
+                "mov %[lo1], 8(%[r],%[i],8)\n\t"
+                "mulx 16(%[a],%[i],8), %[lo0], %[hi]\n\t"
+                "adcx %[h], %[lo0]\n\t"
+                "mov %[lo0], 16(%[r],%[i],8)\n\t"
+                "mulx 24(%[a],%[i],8), %[lo1], %[h]\n\t"
+                "adcx %[hi], %[lo1]\n\t"
+                "mov %[lo1], 24(%[r],%[i],8)\n\t"
+                "lea 4(%[i]), %[i]\n\t"
+                "jrcxz 2f\n\t"
+                "jmp 1b\n"
+                "2:\n\t"
+                "mov $0, %[lo0]\n\t"
+                "adcx %[lo0], %[h]"
+                : [h] "+&r"(h), [i] "+&c"(i), [lo0] "=&r"(lo0), [lo1] "=&r"(lo1), [hi] "=&r"(hi)
+                : [a] "r"(a + n), [r] "r"(r + n), "d"(b)
+                : "cc", "memory");
+
+            return h;
+        }
+
+        limb_t addmul_1_adx(limb_t *r, const limb_t *a, std::size_t n, limb_t b)
+        {
+            std::size_t m = n % 4;
+            limb_t h = addmul_1_portable(r, a, m, b);
+            if (m == n)
+            {
+                return h;
+            }
+
+            std::ptrdiff_t i = (std::ptrdiff_t)m - (std::ptrdiff_t)n;
+            limb_t lo0, lo1, hi;
+            // r[i] += lo[i] + hi[i - 1], the product carries on cf and the
+            // sum with r on of
+            __asm__ volatile(
+                "xor %[lo0], %[lo0]\n\t"
+                "1:\n\t"
+                "mulx (%[a],%[i],8), %[lo0], %[hi]\n\t"
+                "adcx %[h], %[lo0]\n\t"
+                "adox (%[r],%[i],8), %[lo0]\n\t"
+                "mov %[lo0], (%[r],%[i],8)\n\t"
+                "mulx 8(%[a],%[i],8), %[lo1], %[h]\n\t"
+                "adcx %[hi], %[lo1]\n\t"
+                "adox 8(%[r],%[i],8), %[lo1]\n\t"
+                "mov %[lo1], 8(%[r],%[i],8)\n\t"
+                "mulx 16(%[a],%[i],8), %[lo0], %[hi]\n\t"
+                "adcx %[h], %[lo0]\n\t"
+                "adox 16(%[r],%[i],8), %[lo0]\n\t"
+                "mov %[lo0], 16(%[r],%[i],8)\n\t"
+                "mulx 24(%[a],%[i],8), %[lo1], %[h]\n\t"
+                "adcx %[hi], %[lo1]\n\t"
+                "adox 24(%[r],%[i],8), %[lo1]\n\t"
+                "mov %[lo1], 24(%[r],%[i],8)\n\t"
+                "lea 4(%[i]), %[i]\n\t"
+                "jrcxz 2f\n\t"
+                "jmp 1b\n"
+                "2:\n\t"
+                "mov $0, %[lo0]\n\t"
+                "adcx %[lo0], %[h]\n\t"
+                "adox %[lo0], %[h]"
+                : [h] "+&r"(h), [i] "+&c"(i), [lo0] "=&r"(lo0), [lo1] "=&r"(lo1), [hi] "=&r"(hi)
+                : [a] "r"(a + n), [r] "r"(r + n), "d"(b)
+                : "cc", "memory");
+
+            return h;
+        }
+
+        limb_t submul_1_adx(limb_t *r, const limb_t *a, std::size_t n, limb_t b)
+        {
+            std::size_t m = n % 4;
+            limb_t h = submul_1_portable(r, a, m, b);
+            if (m == n)
+            {
+                return h;
+            }
+
+            std::ptrdiff_t i = (std::ptrdiff_t)m - (std::ptrdiff_t)n;
+            limb_t lo0, lo1, hi;
+            bool o;
+            // r[i] -= lo[i] + hi[i - 1] as r[i] + ~(lo[i] + hi[i - 1]) + 1,
+            // the product carrying on cf and the sum with r on of. of starts
+            // set for the + 1, and ends clear if the subtraction borrows
+            __asm__ volatile(
+                "mov $0x7fffffffffffffff, %[lo0]\n\t"
+                "add $1, %[lo0]\n\t"
+                "1:\n\t"
+                "mulx (%[a],%[i],8), %[lo0], %[hi]\n\t"
+                "adcx %[h], %[lo0]\n\t"
+                "not %[lo0]\n\t"
+                "adox (%[r],%[i],8), %[lo0]\n\t"
+                "mov %[lo0], (%[r],%[i],8)\n\t"
+                "mulx 8(%[a],%[i],8), %[lo1], %[h]\n\t"
+                "adcx %[hi], %[lo1]\n\t"
+                "not %[lo1]\n\t"
+                "adox 8(%[r],%[i],8), %[lo1]\n\t"
+                "mov %[lo1], 8(%[r],%[i],8)\n\t"
+                "mulx 16(%[a],%[i],8), %[lo0], %[hi]\n\t"
+                "adcx %[h], %[lo0]\n\t"
+                "not %[lo0]\n\t"
+                "adox 16(%[r],%[i],8), %[lo0]\n\t"
+                "mov %[lo0], 16(%[r],%[i],8)\n\t"
+                "mulx 24(%[a],%[i],8), %[lo1], %[h]\n\t"
+                "adcx %[hi], %[lo1]\n\t"
+                "not %[lo1]\n\t"
+                "adox 24(%[r],%[i],8), %[lo1]\n\t"
+                "mov %[lo1], 24(%[r],%[i],8)\n\t"
+                "lea 4(%[i]), %[i]\n\t"
+                "jrcxz 2f\n\t"
+                "jmp 1b\n"
+                "2:\n\t"
+                "mov $0, %[lo0]\n\t"
+                "adcx %[lo0], %[h]"
+                : [h] "+&r"(h), [i] "+&c"(i), [lo0] "=&r"(lo0), [lo1] "=&r"(lo1), [hi] "=&r"(hi), "=@cco"(o)
+                : [a] "r"(a + n), [r] "r"(r + n), "d"(b)
+                : "cc", "memory");
+
+            return h + !o;
+        }
+    #endif
+
+        int cmp_n(const limb_t *a, const limb_t *b, std::size_t n)
+        {
+            while (n--)
+            {
+                if (a[n] != b[n])
+                {
+                    return (a[n] < b[n]) ? -1 : 1;
+                }
+            }
+
+            return 0;
+        }
+
+        limb_t lshift(limb_t *r, const limb_t *a, std::size_t n, int s)
+        {
+            if (!n)
+            {
+                return 0;
+            }
+
+            limb_t out = a[n - 1] >> (limb_bits - s);
+            for (std::size_t i = n - 1; i > 0; i--)
+            {
+                r[i] = (a[i] << s) | (a[i - 1] >> (limb_bits - s));
+            }
+            r[0] = a[0] << s;
+
+            return out;
+        }
+
+        limb_t rshift(limb_t *r, const limb_t *a, std::size_t n, int s)
+        {
+            if (!n)
+            {
+                return 0;
+            }
+
+            limb_t out = a[0] << (limb_bits - s);
+            for (std::size_t i = 0; i + 1 < n; i++)
+            {
+                r[i] = (a[i] >> s) | (a[i + 1] << (limb_bits - s));
+            }
+            r[n - 1] = a[n - 1] >> s;
+
+            return out;
+        }
+
+        limb_t divrem_1(limb_t *q, const limb_t *a, std::size_t n, limb_t d)
+        {
+            if (!n)
+            {
+                return 0;
+            }
+
+            // normalize d and divide by multiplying with its reciprocal
+            // v = floor((B^2 - 1) / d) - B (moller and granlund), feeding in
+            // the limbs of a shifted by the same amount
+            int s = count_leading_zeros(d);
+            d <<= s;
+            limb_t v = (limb_t)((((dlimb_t)~d) << limb_bits | (limb_t)~(limb_t)0) / d);
+            limb_t rem = s ? a[n - 1] >> (limb_bits - s) : 0;
+            while (n--)
+            {
+                limb_t u = a[n] << s;
+                if (s && n)
+                {
+                    u |= a[n - 1] >> (limb_bits - s);
+                }
+
+                dlimb_t t = (dlimb_t)v * rem + (((dlimb_t)(rem + 1) << limb_bits) | u);
+                limb_t qh = (limb_t)(t >> limb_bits), ql = (limb_t)t;
+                limb_t r = u - qh * d;
+                if (r > ql)
+                {
+                    qh--;
+                    r += d;
+                }
+                if (r >= d)
+                {
+                    qh++;
+                    r -= d;
+                }
+
+                if (q)
+                {
+                    q[n] = qh;
+                }
+                rem = r;
+            }
+
+            return rem >> s;
+        }
+
+        void divexact_1(limb_t *q, const limb_t *a, std::size_t n, limb_t d)
+        {
+            if (!n)
+            {
+                return;
+            }
+
+            // remove the factors of two with a shift, then divide by the odd
+            // part by multiplying with its inverse mod B, which needs no
+            // division instructions
+            int t = 0;
+            while (!(d & 1))
+            {
+                d >>= 1;
+                t++;
+            }
+
+            if (t)
+            {
+                rshift(q, a, n, t);
+                a = q;
+            }
+
+            // newton iteration for the inverse, each step doubles the correct bits
+            limb_t inv = d;
+            for (int i = 0; i < 6; i++)
+            {
+                inv *= 2 - d * inv;
+            }
+
+            limb_t c = 0;
+            for (std::size_t i = 0; i < n; i++)
+            {
+                limb_t s = a[i];
+                limb_t l = s - c;
+                c = (s < c);
+                limb_t x = l * inv;
+                q[i] = x;
+                c += (limb_t)(((dlimb_t)x * d) >> limb_bits);
+            }
+        }
+
+        void mul_basecase(limb_t *r, const limb_t *a, std::size_t n, const limb_t *b, std::size_t m)
+        {
+            r[n] = mul_1(r, a, n, b[0]);
+            for (std::size_t j = 1; j < m; j++)
+            {
+                r[n + j] = addmul_1(r + j, a, n, b[j]);
+            }
+        }
+
+        void sqr_basecase(limb_t *r, const limb_t *a, std::size_t n)
+        {
+            // the products a[i] a[j] for i < j, doubled, then the squares a[i]^2
+            std::fill(r, r + 2 * n, 0);
+            for (std::size_t i = 0; i + 1 < n; i++)
+            {
+                r[i + n] = addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+            }
+            lshift(r, r, 2 * n, 1);
+
+            limb_t c = 0;
+            for (std::size_t i = 0; i < n; i++)
+            {
+                dlimb_t p = (dlimb_t)a[i] * a[i];
+                dlimb_t lo = (dlimb_t)r[2 * i] + (limb_t)p + c;
+                dlimb_t hi = (dlimb_t)r[2 * i + 1] + (limb_t)(p >> limb_bits) + (limb_t)(lo >> limb_bits);
+                r[2 * i] = (limb_t)lo;
+                r[2 * i + 1] = (limb_t)hi;
+                c = (limb_t)(hi >> limb_bits);
+            }
+        }
+
+        std::size_t normalized_size(const limb_t *a, std::size_t n)
+        {
+            while (n && !a[n - 1])
+            {
+                n--;
+            }
+
+            return n;
+        }
+
+        int count_leading_zeros(limb_t x)
+        {
+        #if defined(__GNUC__)
+            return (sizeof(limb_t) == sizeof(unsigned long long)) ? __builtin_clzll(x) : __builtin_clz(x);
+        #else
+            int n = 0;
+            for (limb_t top = (limb_t)1 << (limb_bits - 1); !(x & top); x <<= 1)
+            {
+                n++;
+            }
+            return n;
+        #endif
+        }
+
+        void divrem_knuth(limb_t *q, limb_t *r, const limb_t *a, std::size_t n, const limb_t *d, std::size_t m)
+        {
+            // short operands are copied to the stack, longer ones to scratch
+            limb_t small[2 * limb_vector::inline_limbs + 2];
+            scratch_vector big;
+            limb_t *dn = small, *an = small + m;
+            if (n + 1 + m > sizeof(small) / sizeof(limb_t))
+            {
+                big.resize(n + 1 + m);
+                dn = big.data();
+                an = dn + m;
+            }
+            std::copy(d, d + m, dn);
+            std::copy(a, a + n, an);
+            an[n] = 0;
+
+            // normalize so the top bit of the divisor is set, which makes the
+            // quotient estimate from the top two limbs at most two too large
+            int s = count_leading_zeros(d[m - 1]);
+            if (s)
+            {
+                lshift(dn, d, m, s);
+                an[n] = lshift(an, a, n, s);
+            }
+
+            const limb_t d1 = dn[m - 1], d0 = dn[m - 2];
+            for (std::size_t j = n - m + 1; j-- > 0;)
+            {
+                limb_t *u = an + j;
+
+                // estimate the quotient limb from the top two limbs of the
+                // remainder, and refine it with the third
+                dlimb_t num = ((dlimb_t)u[m] << limb_bits) | u[m - 1];
+                dlimb_t qhat = num / d1, rhat = num % d1;
+                while ((qhat >> limb_bits) || qhat * d0 > ((rhat << limb_bits) | u[m - 2]))
+                {
+                    qhat--;
+                    rhat += d1;
+                    if (rhat >> limb_bits)
+                    {
+                        break;
+                    }
+                }
+
+                // subtract qhat d, and add d back in the rare case it was one too big
+                limb_t borrow = submul_1(u, dn, m, (limb_t)qhat);
+                limb_t top = u[m];
+                u[m] = top - borrow;
+                if (top < borrow)
+                {
+                    qhat--;
+                    u[m] += add_n(u, u, dn, m);
+                }
+
+                q[j] = (limb_t)qhat;
+            }
+
+            // the remainder is what is left of a, shifted back
+            if (s)
+            {
+                rshift(r, an, m, s);
+            }
+            else
+            {
+                std::copy(an, an + m, r);
+            }
+        }
+
+        // add a (n limbs) into r (rn limbs, rn >= n), propagating the carry
+        // through the rest of r. returns the carry out of r
+        limb_t add_into(limb_t *r, std::size_t rn, const limb_t *a, std::size_t n)
+        {
+            limb_t c = add_n(r, r, a, n);
+            if (c && rn > n)
+            {
+                c = add_1(r + n, r + n, rn - n, c);
+            }
+
+            return c;
+        }
+
+        // |a| + |b| into a, both magnitudes
+        void magnitude_add(scratch_vector &a, const scratch_vector &b)
+        {
+            if (a.size() < b.size())
+            {
+                a.resize(b.size(), 0);
+            }
+
+            limb_t c = add_into(a.data(), a.size(), b.data(), b.size());
+            if (c)
+            {
+                a.push_back(c);
+            }
+        }
+
+        // ||a| - |b|| into a, both magnitudes. returns true if |b| > |a|
+        bool magnitude_sub(scratch_vector &a, const scratch_vector &b)
+        {
+            std::size_t n = a.size(), m = b.size();
+            bool swapped = (n < m) || (n == m && cmp_n(a.data(), b.data(), n) < 0);
+
+            if (swapped)
+            {
+                scratch_vector t = b;
+                limb_t c = sub_n(t.data(), t.data(), a.data(), n);
+                sub_1(t.data() + n, t.data() + n, m - n, c);
+                a.swap(t);
+            }
+            else
+            {
+                limb_t c = sub_n(a.data(), a.data(), b.data(), m);
+                sub_1(a.data() + m, a.data() + m, n - m, c);
+            }
+
+            a.resize(normalized_size(a.data(), a.size()));
+            return swapped;
+        }
+
+        void signed_add(signed_limbs &a, const signed_limbs &b)
+        {
+            if (a.neg == b.neg)
+            {
+                magnitude_add(a.mag, b.mag);
+                return;
+            }
+
+            if (magnitude_sub(a.mag, b.mag))
+            {
+                a.neg = b.neg;
+            }
+            if (a.mag.empty())
+            {
+                a.neg = false;
+            }
+        }
+
+        void signed_sub(signed_limbs &a, const signed_limbs &b)
+        {
+            if (a.neg != b.neg)
+            {
+                magnitude_add(a.mag, b.mag);
+                return;
+            }
+
+            if (magnitude_sub(a.mag, b.mag))
+            {
+                a.neg = !a.neg;
+            }
+            if (a.mag.empty())
+            {
+                a.neg = false;
+            }
+        }
+
+        void signed_mul_1(signed_limbs &a, long long x)
+        {
+            if (x == 1 || x == -1)
+            {
+                a.neg = !a.mag.empty() && (a.neg != (x < 0));
+                return;
+            }
+
+            limb_t c = mul_1(a.mag.data(), a.mag.data(), a.mag.size(), (limb_t)(x < 0 ? -x : x));
+            if (c)
+            {
+                a.mag.push_back(c);
+            }
+
+            a.mag.resize(normalized_size(a.mag.data(), a.mag.size()));
+            a.neg = !a.mag.empty() && (a.neg != (x < 0));
+        }
+
+        void signed_divexact_1(signed_limbs &a, long long x)
+        {
+            divexact_1(a.mag.data(), a.mag.data(), a.mag.size(), (limb_t)(x < 0 ? -x : x));
+
+            a.mag.resize(normalized_size(a.mag.data(), a.mag.size()));
+            a.neg = !a.mag.empty() && (a.neg != (x < 0));
+        }
+
+        mul_thresholds &mul_config()
+        {
+            static mul_thresholds config;
+            return config;
+        }
+
+        void mul(limb_t *r, const limb_t *a, std::size_t n, const limb_t *b, std::size_t m)
+        {
+            mul(r, a, n, b, m, use_parallel(std::min(n, m)));
+        }
+
+        void mul(limb_t *r, const limb_t *a, std::size_t n, const limb_t *b, std::size_t m, bool parallel)
+        {
+            if (n < m)
+            {
+                std::swap(a, b);
+                std::swap(n, m);
+            }
+
+            if (!m)
+            {
+                std::fill(r, r + n, 0);
+                return;
+            }
+
+        #if defined(__SIZEOF_INT128__)
+            // the transform length only depends on n + m, so there is no need
+            // to split unbalanced operands
+            if (m >= mul_config().ntt)
+            {
+                mul_ntt(r, a, n, b, m, parallel);
+                return;
+            }
+        #endif
+
+            if (m < mul_config().karatsuba)
+            {
+                if (a == b && n == m)
+                {
+                    sqr_basecase(r, a, n);
+                }
+                else
+                {
+                    mul_basecase(r, a, n, b, m);
+                }
+                return;
+            }
+
+            if (n == m)
+            {
+                mul_n(r, a, b, n, parallel);
+                return;
+            }
+
+            // unbalanced operands, split a into chunks the size of b and
+            // accumulate the balanced products
+            std::fill(r, r + n + m, 0);
+            if (parallel)
+            {
+                // each chunk gets its own product buffer, to add in order after
+                std::size_t chunks = (n + m - 1) / m;
+                scratch_vector t(chunks * 2 * m);
+                parallel_for(true, chunks, 1, [&](std::size_t lo, std::size_t hi)
+                {
+                    for (std::size_t i = lo; i < hi; i++)
+                    {
+                        mul(&t[i * 2 * m], a + i * m, std::min(m, n - i * m), b, m);
+                    }
+                });
+
+                for (std::size_t i = 0; i < chunks; i++)
+                {
+                    std::size_t off = i * m;
+                    add_into(r + off, n + m - off, &t[i * 2 * m], std::min(m, n - off) + m);
+                }
+                return;
+            }
+
+            scratch_vector t(2 * m);
+            for (std::size_t off = 0; off < n; off += m)
+            {
+                std::size_t len = std::min(m, n - off);
+                mul(t.data(), a + off, len, b, m);
+                add_into(r + off, n + m - off, t.data(), len + m);
+            }
+        }
+
+        limb_t addmul(limb_t *r, std::size_t rn, const limb_t *a, std::size_t n, const limb_t *b, std::size_t m)
+        {
+            if (n < m)
+            {
+                std::swap(a, b);
+                std::swap(n, m);
+            }
+
+            if (!m)
+            {
+                return 0;
+            }
+
+            if (m >= mul_config().karatsuba)
+            {
+                // a subquadratic product needs its own buffer, add it after
+                scratch_vector t(n + m);
+                mul(t.data(), a, n, b, m);
+                return add_into(r, rn, t.data(), n + m);
+            }
+
+            // accumulate one row per limb of b straight into r. each row
+            // carry usually stops within a limb, so propagate it by hand
+            limb_t carry = 0;
+            for (std::size_t j = 0; j < m; j++)
+            {
+                limb_t c = addmul_1(r + j, a, n, b[j]);
+                for (std::size_t i = j + n; c && i < rn; i++)
+                {
+                    r[i] += c;
+                    c = (r[i] < c);
+                }
+                carry += c;
+            }
+
+            return carry;
+        }
+
+        limb_t submul(limb_t *r, std::size_t rn, const limb_t *a, std::size_t n, const limb_t *b, std::size_t m)
+        {
+            if (n < m)
+            {
+                std::swap(a, b);
+                std::swap(n, m);
+            }
+
+            if (!m)
+            {
+                return 0;
+            }
+
+            if (m >= mul_config().karatsuba)
+            {
+                scratch_vector t(n + m);
+                mul(t.data(), a, n, b, m);
+                limb_t c = sub_n(r, r, t.data(), n + m);
+                if (c && rn > n + m)
+                {
+                    c = sub_1(r + n + m, r + n + m, rn - n - m, c);
+                }
+
+                return c;
+            }
+
+            limb_t borrow = 0;
+            for (std::size_t j = 0; j < m; j++)
+            {
+                limb_t c = submul_1(r + j, a, n, b[j]);
+                for (std::size_t i = j + n; c && i < rn; i++)
+                {
+                    limb_t t = r[i];
+                    r[i] = t - c;
+                    c = (t < c);
+                }
+                borrow += c;
+            }
+
+            return borrow;
+        }
+
+        void mul_n(limb_t *r, const limb_t *a, const limb_t *b, std::size_t n)
+        {
+            mul_n(r, a, b, n, use_parallel(n));
+        }
+
+        void mul_n(limb_t *r, const limb_t *a, const limb_t *b, std::size_t n, bool parallel)
+        {
+            const mul_thresholds &config = mul_config();
+
+            if (n < config.karatsuba)
+            {
+                if (a == b)
+                {
+                    sqr_basecase(r, a, n);
+                }
+                else
+                {
+                    mul_basecase(r, a, n, b, n);
+                }
+            }
+        #if defined(__SIZEOF_INT128__)
+            else if (n >= config.ntt)
+            {
+                mul_ntt(r, a, n, b, n, parallel);
+            }
+        #endif
+            else if (n < config.toom3)
+            {
+                mul_karatsuba(r, a, b, n, parallel);
+            }
+            else if (n < config.toom4)
+            {
+                mul_toom(r, a, b, n, 3, parallel);
+            }
+            else
+            {
+                mul_toom(r, a, b, n, 4, parallel);
+            }
+        }
+
+        void sqr(limb_t *r, const limb_t *a, std::size_t n)
+        {
+            // mul_n squares below the karatsuba threshold when both operands
+            // are the same, and karatsuba passes that down to its halves
+            mul_n(r, a, a, n);
+        }
+
+        void mul_karatsuba(limb_t *r, const limb_t *a, const limb_t *b, std::size_t n, bool parallel)
+        {
+            // a = a0 + a1 B^l, b = b0 + b1 B^l, with the high halves h <= l limbs
+            std::size_t l = n - n / 2, h = n / 2;
+            const limb_t *a0 = a, *a1 = a + l, *b0 = b, *b1 = b + l;
+
+            // |a0 - a1| and |b0 - b1|, keeping track of the sign of their product
+            scratch_vector da(l), db(l), t(2 * l), mid(2 * l + 1);
+            bool neg = false;
+            for (int i = 0; i < 2; i++)
+            {
+                const limb_t *x0 = i ? b0 : a0, *x1 = i ? b1 : a1;
+                limb_t *d = i ? db.data() : da.data();
+
+                bool less = (l == h || !x0[h]) && cmp_n(x0, x1, h) < 0;
+                if (less)
+                {
+                    sub_n(d, x1, x0, h);
+                    if (l > h)
+                    {
+                        d[h] = 0;
+                    }
+                }
+                else
+                {
+                    limb_t c = sub_n(d, x0, x1, h);
+                    if (l > h)
+                    {
+                        d[h] = x0[h] - c;
+                    }
+                }
+                neg ^= less;
+            }
+
+            // z0 = a0 b0 in the low half of r, z2 = a1 b1 in the high half and
+            // t = (a0 - a1)(b0 - b1). a square keeps squaring its halves
+            parallel_for(parallel, 3, 1, [&](std::size_t lo, std::size_t hi)
+            {
+                for (std::size_t i = lo; i < hi; i++)
+                {
+                    if (i == 0)
+                    {
+                        mul_n(r, a0, b0, l);
+                    }
+                    else if (i == 1)
+                    {
+                        mul(r + 2 * l, a1, h, b1, h);
+                    }
+                    else
+                    {
+                        mul_n(t.data(), da.data(), a == b ? da.data() : db.data(), l);
+                    }
+                }
+            });
+
+            // z1 = z0 + z2 - (a0 - a1)(b0 - b1)
+            std::copy(r, r + 2 * l, mid.begin());
+            mid[2 * l] = add_into(mid.data(), 2 * l, r + 2 * l, 2 * h);
+            if (neg)
+            {
+                add_into(mid.data(), 2 * l + 1, t.data(), 2 * l);
+            }
+            else
+            {
+                mid[2 * l] -= sub_n(mid.data(), mid.data(), t.data(), 2 * l);
+            }
+
+            add_into(r + l, 2 * n - l, mid.data(), normalized_size(mid.data(), 2 * l + 1));
+        }
+
+        void mul_toom(limb_t *r, const limb_t *a, const limb_t *b, std::size_t n, int k, bool parallel)
+        {
+            // split a and b into k parts of s limbs, as polynomials in x = B^s,
+            // and multiply them by evaluating at the points 0, 1, -1, 2, -2, ...
+            // and infinity, then interpolating the product from its values
+            std::size_t s = (n + k - 1) / k;
+            int p = 2 * k - 2;
+            scratch_array<long long> x(p);
+            for (int j = 1; j < p; j++)
+            {
+                x[j] = (j & 1) ? (j + 1) / 2 : -(j / 2);
+            }
+
+            // the even and odd halves of the polynomial at a positive point,
+            // so u(at) = even + odd and u(-at) = even - odd
+            auto evaluate = [&](const limb_t *u, limb_t at, signed_limbs &even, signed_limbs &odd)
+            {
+                even = signed_limbs();
+                odd = signed_limbs();
+                for (int i = k - 1; i >= 0; i--)
+                {
+                    signed_limbs &v = (i & 1) ? odd : even;
+                    std::size_t lo = std::min<std::size_t>(n, i * s), hi = std::min<std::size_t>(n, (i + 1) * s);
+
+                    if (at != 1)
+                    {
+                        limb_t c = mul_1(v.mag.data(), v.mag.data(), v.mag.size(), at * at);
+                        if (c)
+                        {
+                            v.mag.push_back(c);
+                        }
+                    }
+
+                    if (v.mag.size() < hi - lo)
+                    {
+                        v.mag.resize(hi - lo, 0);
+                    }
+                    limb_t c = add_into(v.mag.data(), v.mag.size(), u + lo, hi - lo);
+                    if (c)
+                    {
+                        v.mag.push_back(c);
+                    }
+                }
+
+                if (at != 1)
+                {
+                    signed_mul_1(odd, at);
+                }
+                even.mag.resize(normalized_size(even.mag.data(), even.mag.size()));
+                odd.mag.resize(normalized_size(odd.mag.data(), odd.mag.size()));
+            };
+
+            // the operands of the products, u[j] w[j] = v[j] at the finite
+            // points and u[p] w[p] the leading coefficient, the value at
+            // infinity. the value at 0 is a0 b0
+            scratch_array<signed_limbs> u(p + 1), w(p + 1), v(p + 1);
+            {
+                std::size_t lo = std::min<std::size_t>(n, (k - 1) * s);
+                u[p].mag.assign(a + lo, a + n);
+                w[p].mag.assign(b + lo, b + n);
+                u[0].mag.assign(a, a + std::min(n, s));
+                w[0].mag.assign(b, b + std::min(n, s));
+                for (int j = 0; j <= p; j += p)
+                {
+                    u[j].mag.resize(normalized_size(u[j].mag.data(), u[j].mag.size()));
+                    w[j].mag.resize(normalized_size(w[j].mag.data(), w[j].mag.size()));
+                }
+            }
+
+            for (int j = 1; j < p; j += 2)
+            {
+                signed_limbs ae, ao, be, bo;
+                evaluate(a, x[j], ae, ao);
+                evaluate(b, x[j], be, bo);
+
+                u[j] = ae;
+                w[j] = be;
+                signed_add(u[j], ao);
+                signed_add(w[j], bo);
+
+                if (j + 1 < p)
+                {
+                    signed_sub(ae, ao);
+                    signed_sub(be, bo);
+                    u[j + 1] = std::move(ae);
+                    w[j + 1] = std::move(be);
+                }
+            }
+
+            // the products, which are independent. their buffers are made
+            // here, as scratch memory is freed by the thread that allocated it
+            for (int j = 0; j <= p; j++)
+            {
+                v[j].mag.resize(u[j].mag.size() + w[j].mag.size());
+            }
+            parallel_for(parallel, p + 1, 1, [&](std::size_t lo, std::size_t hi)
+            {
+                for (std::size_t j = lo; j < hi; j++)
+                {
+                    mul(v[j].mag.data(), u[j].mag.data(), u[j].mag.size(), w[j].mag.data(), w[j].mag.size());
+                }
+            });
+            for (int j = 0; j <= p; j++)
+            {
+                v[j].mag.resize(normalized_size(v[j].mag.data(), v[j].mag.size()));
+                v[j].neg = !v[j].mag.empty() && (u[j].neg != w[j].neg);
+            }
+
+            signed_limbs top = std::move(v[p]);
+            v.pop_back();
+
+            // remove the leading term, so the rest is a polynomial of degree
+            // p - 1 that the p finite points determine
+            for (int j = 1; j < p; j++)
+            {
+                long long power = 1;
+                for (int i = 0; i < p; i++)
+                {
+                    power *= x[j];
+                }
+
+                signed_limbs t = top;
+                signed_mul_1(t, power);
+                signed_sub(v[j], t);
+            }
+
+            // newton divided differences. all divisions are exact as the
+            // polynomial has integer coefficients and the points are integers
+            for (int level = 1; level < p; level++)
+            {
+                for (int j = p - 1; j >= level; j--)
+                {
+                    signed_sub(v[j], v[j - 1]);
+                    signed_divexact_1(v[j], x[j] - x[j - level]);
+                }
+            }
+
+            // expand the newton form into coefficients, c = c (x - x[j]) + v[j]
+            scratch_array<signed_limbs> c(p);
+            c[0] = v[p - 1];
+            for (int j = p - 2, deg = 0; j >= 0; j--, deg++)
+            {
+                for (int i = deg + 1; i > 0; i--)
+                {
+                    signed_mul_1(c[i], -x[j]);
+                    signed_add(c[i], c[i - 1]);
+                }
+                signed_mul_1(c[0], -x[j]);
+                signed_add(c[0], v[j]);
+            }
+            c.push_back(top);
+
+            // the coefficients are all non negative, recombine them at B^s
+            std::fill(r, r + 2 * n, 0);
+            for (std::size_t i = 0; i < c.size(); i++)
+            {
+                std::size_t off = i * s;
+                if (!c[i].mag.empty())
+                {
+                    add_into(r + off, 2 * n - off, c[i].mag.data(), c[i].mag.size());
+                }
+            }
+        }
+
+    #if defined(__SIZEOF_INT128__)
+        ntt_prime::ntt_prime(std::uint64_t p, std::uint64_t g) : p(p), g(g)
+        {
+            std::uint64_t inv = p;
+            for (int i = 0; i < 6; i++)
+            {
+                inv *= 2 - p * inv;
+            }
+            pinv = -inv;
+
+            r2 = (std::uint64_t)(((dlimb_t)1 << 64) % p);
+            r2 = (std::uint64_t)((dlimb_t)r2 * r2 % p);
+        }
+
+        std::uint64_t ntt_prime::mul(std::uint64_t a, std::uint64_t b) const
+        {
+            dlimb_t t = (dlimb_t)a * b;
+            std::uint64_t m = (std::uint64_t)t * pinv;
+            std::uint64_t u = (std::uint64_t)((t + (dlimb_t)m * p) >> 64);
+            return (u >= p) ? u - p : u;
+        }
+
+        std::uint64_t ntt_prime::to_mont(std::uint64_t x) const
+        {
+            return mul(x % p, r2);
+        }
+
+        std::uint64_t ntt_prime::pow(std::uint64_t a, std::uint64_t e) const
+        {
+            std::uint64_t x = to_mont(1);
+            for (; e; e >>= 1)
+            {
+                if (e & 1)
+                {
+                    x = mul(x, a);
+                }
+                a = mul(a, a);
+            }
+
+            return x;
+        }
+
+        const ntt_prime &ntt_prime_at(int i)
+        {
+            static const ntt_prime primes[3] = {
+                ntt_prime(4179340454199820289ULL, 3), // 29 * 2^57 + 1
+                ntt_prime(2485986994308513793ULL, 5), // 69 * 2^55 + 1
+                ntt_prime(1945555039024054273ULL, 5), // 27 * 2^56 + 1
+            };
+
+            return primes[i];
+        }
+
+        void ntt_forward(std::uint64_t *a, std::size_t n, const std::uint64_t *roots, const ntt_prime &q, bool parallel)
+        {
+            // decimation in frequency, natural order in, bit reversed out
+            const std::uint64_t p = q.p;
+            // takes its own copy of p, as capturing it would make the loops
+            // below reload it after every store
+            auto level = [p, roots, &q](std::uint64_t *x, std::size_t h, std::size_t lo, std::size_t hi)
+            {
+                std::uint64_t *y = x + h;
+                for (std::size_t j = lo; j < hi; j++)
+                {
+                    std::uint64_t u = x[j], v = y[j];
+                    std::uint64_t t = u + v;
+                    x[j] = (t >= p) ? t - p : t;
+                    y[j] = q.mul(u + p - v, roots[h + j]);
+                }
+            };
+
+            if (parallel && n > ntt_grain)
+            {
+                std::size_t h = n / 2;
+                parallel_for(true, h, ntt_grain, [&](std::size_t lo, std::size_t hi)
+                {
+                    level(a, h, lo, hi);
+                });
+                parallel_for(true, 2, 1, [&](std::size_t lo, std::size_t hi)
+                {
+                    for (std::size_t i = lo; i < hi; i++)
+                    {
+                        ntt_forward(a + i * h, h, roots, q, true);
+                    }
+                });
+                return;
+            }
+
+            if (n > ntt_block)
+            {
+                std::size_t h = n / 2;
+                level(a, h, 0, h);
+                ntt_forward(a, h, roots, q, false);
+                ntt_forward(a + h, h, roots, q, false);
+                return;
+            }
+
+            for (std::size_t h = n / 2; h; h /= 2)
+            {
+                for (std::size_t s = 0; s < n; s += 2 * h)
+                {
+                    std::uint64_t *x = a + s, *y = a + s + h;
+                    for (std::size_t j = 0; j < h; j++)
+                    {
+                        std::uint64_t u = x[j], v = y[j];
+                        std::uint64_t t = u + v;
+                        x[j] = (t >= p) ? t - p : t;
+                        y[j] = q.mul(u + p - v, roots[h + j]);
+                    }
+                }
+            }
+        }
+
+        void ntt_inverse(std::uint64_t *a, std::size_t n, const std::uint64_t *roots, const ntt_prime &q, bool parallel)
+        {
+            // decimation in time, bit reversed in, natural order out
+            const std::uint64_t p = q.p;
+            // takes its own copy of p, as capturing it would make the loops
+            // below reload it after every store
+            auto level = [p, roots, &q](std::uint64_t *x, std::size_t h, std::size_t lo, std::size_t hi)
+            {
+                std::uint64_t *y = x + h;
+                for (std::size_t j = lo; j < hi; j++)
+                {
+                    std::uint64_t u = x[j], v = q.mul(y[j], roots[h + j]);
+                    std::uint64_t t = u + v;
+                    x[j] = (t >= p) ? t - p : t;
+                    y[j] = (u >= v) ? u - v : u + p - v;
+                }
+            };
+
+            if (parallel && n > ntt_grain)
+            {
+                std::size_t h = n / 2;
+                parallel_for(true, 2, 1, [&](std::size_t lo, std::size_t hi)
+                {
+                    for (std::size_t i = lo; i < hi; i++)
+                    {
+                        ntt_inverse(a + i * h, h, roots, q, true);
+                    }
+                });
+                parallel_for(true, h, ntt_grain, [&](std::size_t lo, std::size_t hi)
+                {
+                    level(a, h, lo, hi);
+                });
+                return;
+            }
+
+            if (n > ntt_block)
+            {
+                std::size_t h = n / 2;
+                ntt_inverse(a, h, roots, q, false);
+                ntt_inverse(a + h, h, roots, q, false);
+                level(a, h, 0, h);
+                return;
+            }
+
+            for (std::size_t h = 1; h < n; h *= 2)
+            {
+                for (std::size_t s = 0; s < n; s += 2 * h)
+                {
+                    std::uint64_t *x = a + s, *y = a + s + h;
+                    for (std::size_t j = 0; j < h; j++)
+                    {
+                        std::uint64_t u = x[j], v = q.mul(y[j], roots[h + j]);
+                        std::uint64_t t = u + v;
+                        x[j] = (t >= p) ? t - p : t;
+                        y[j] = (u >= v) ? u - v : u + p - v;
+                    }
+                }
+            }
+        }
+
+        void mul_ntt(limb_t *r, const limb_t *a, std::size_t n, const limb_t *b, std::size_t m, bool parallel)
+        {
+            std::size_t len = 1, k = n + m;
+            while (len < k)
+            {
+                len *= 2;
+            }
+
+            bool square = (a == b && n == m);
+            scratch_array<std::uint64_t> res[3], fb(square ? 0 : len), roots(len);
+
+            for (int i = 0; i < 3; i++)
+            {
+                const ntt_prime &q = ntt_prime_at(i);
+                scratch_array<std::uint64_t> &fa = res[i];
+
+                // the 2h-th roots of unity for every level, roots[h + j] = w_2h^j
+                auto fill_roots = [&](bool inverse)
+                {
+                    for (std::size_t h = 1; h < len; h *= 2)
+                    {
+                        std::uint64_t w = q.pow(q.to_mont(q.g), (q.p - 1) / (2 * h));
+                        if (inverse)
+                        {
+                            w = q.pow(w, q.p - 2);
+                        }
+
+                        parallel_for(parallel, h, ntt_grain, [&](std::size_t lo, std::size_t hi)
+                        {
+                            std::uint64_t x = q.pow(w, lo);
+                            for (std::size_t j = lo; j < hi; j++)
+                            {
+                                roots[h + j] = x;
+                                x = q.mul(x, w);
+                            }
+                        });
+                    }
+                };
+
+                // the residues of u, count limbs, zero padded to len
+                auto residues = [&](std::uint64_t *f, const limb_t *u, std::size_t count)
+                {
+                    std::fill(f + count, f + len, 0);
+                    parallel_for(parallel, count, ntt_grain, [&](std::size_t lo, std::size_t hi)
+                    {
+                        for (std::size_t j = lo; j < hi; j++)
+                        {
+                            f[j] = u[j] % q.p;
+                        }
+                    });
+                };
+
+                fa.resize(len);
+                residues(fa.data(), a, n);
+
+                fill_roots(false);
+                ntt_forward(fa.data(), len, roots.data(), q, parallel);
+                if (!square)
+                {
+                    residues(fb.data(), b, m);
+                    ntt_forward(fb.data(), len, roots.data(), q, parallel);
+                }
+
+                // the pointwise products. the values are in normal form, so the
+                // montgomery product divides by R, which the scale R^2 / len
+                // undoes while applying the 1 / len of the inverse transform
+                const scratch_array<std::uint64_t> &g = square ? fa : fb;
+                std::uint64_t scale = q.mul(q.pow(q.to_mont(len), q.p - 2), q.r2);
+                parallel_for(parallel, len, ntt_grain, [&](std::size_t lo, std::size_t hi)
+                {
+                    for (std::size_t j = lo; j < hi; j++)
+                    {
+                        fa[j] = q.mul(q.mul(fa[j], g[j]), scale);
+                    }
+                });
+
+                fill_roots(true);
+                ntt_inverse(fa.data(), len, roots.data(), q, parallel);
+            }
+
+            // recombine each coefficient from its three residues with garner's
+            // algorithm, x = r0 + p0 t1 + p0 p1 t2, and carry them into r
+            const ntt_prime &q0 = ntt_prime_at(0), &q1 = ntt_prime_at(1), &q2 = ntt_prime_at(2);
+            const std::uint64_t p0 = q0.p, p1 = q1.p, p2 = q2.p;
+            // p0^-1 mod p1, p0 mod p2 and (p0 p1)^-1 mod p2, in montgomery form
+            const std::uint64_t c01 = q1.pow(q1.to_mont(p0), p1 - 2);
+            const std::uint64_t c02 = q2.to_mont(p0);
+            const std::uint64_t c012 = q2.pow(q2.mul(q2.to_mont(p0), q2.to_mont(p1)), p2 - 2);
+            const dlimb_t p01 = (dlimb_t)p0 * p1;
+            const std::uint64_t p01_lo = (std::uint64_t)p01, p01_hi = (std::uint64_t)(p01 >> 64);
+
+            // chunks of coefficients are recombined on their own, each leaving
+            // a three limb carry to add in above it afterwards
+            std::size_t chunk = parallel ? std::max(ntt_grain, k / (4 * thread_count()) + 1) : k;
+            std::size_t chunks = (k + chunk - 1) / chunk;
+            scratch_array<std::uint64_t> carry(3 * chunks);
+            parallel_for(parallel, chunks, 1, [&](std::size_t clo, std::size_t chi)
+            {
+                for (std::size_t c = clo; c < chi; c++)
+                {
+                    std::uint64_t acc0 = 0, acc1 = 0, acc2 = 0;
+                    for (std::size_t j = c * chunk; j < std::min(k, (c + 1) * chunk); j++)
+                    {
+                        std::uint64_t r0 = res[0][j], r1 = res[1][j], r2 = res[2][j];
+
+                        std::uint64_t d = r0 % p1;
+                        d = (r1 >= d) ? r1 - d : r1 + p1 - d;
+                        std::uint64_t t1 = q1.mul(d, c01);
+
+                        std::uint64_t e = r0 % p2 + q2.mul(t1, c02);
+                        e = (e >= p2) ? e - p2 : e;
+                        e = (r2 >= e) ? r2 - e : r2 + p2 - e;
+                        std::uint64_t t2 = q2.mul(e, c012);
+
+                        dlimb_t lo = (dlimb_t)p0 * t1 + r0;
+                        dlimb_t m0 = (dlimb_t)p01_lo * t2;
+                        dlimb_t m1 = (dlimb_t)p01_hi * t2;
+
+                        dlimb_t s0 = (dlimb_t)acc0 + (std::uint64_t)lo + (std::uint64_t)m0;
+                        dlimb_t s1 = (dlimb_t)acc1 + (std::uint64_t)(lo >> 64) + (std::uint64_t)(m0 >> 64)
+                            + (std::uint64_t)m1 + (std::uint64_t)(s0 >> 64);
+                        dlimb_t s2 = (dlimb_t)acc2 + (std::uint64_t)(m1 >> 64) + (std::uint64_t)(s1 >> 64);
+
+                        r[j] = (limb_t)s0;
+                        acc0 = (std::uint64_t)s1;
+                        acc1 = (std::uint64_t)s2;
+                        acc2 = (std::uint64_t)(s2 >> 64);
+                    }
+
+                    carry[3 * c] = acc0;
+                    carry[3 * c + 1] = acc1;
+                    carry[3 * c + 2] = acc2;
+                }
+            });
+
+            // the carry out of the last chunk is zero, as the product fits
+            for (std::size_t c = 0; c + 1 < chunks; c++)
+            {
+                std::size_t off = (c + 1) * chunk;
+                add_into(r + off, k - off, &carry[3 * c], std::min<std::size_t>(3, k - off));
+            }
+        }
+    #endif
+
+        // the product of a and b as a normalized vector
+        scratch_vector mul_vector(const limb_t *a, std::size_t n, const limb_t *b, std::size_t m)
+        {
+            n = normalized_size(a, n);
+            m = normalized_size(b, m);
+            scratch_vector r(n + m);
+            mul(r.data(), a, n, b, m);
+            r.resize(normalized_size(r.data(), r.size()));
+            return r;
+        }
+
+        // compare two normalized vectors
+        int cmp_vector(const scratch_vector &a, const scratch_vector &b)
+        {
+            if (a.size() != b.size())
+            {
+                return (a.size() < b.size()) ? -1 : 1;
+            }
+
+            return cmp_n(a.data(), b.data(), a.size());
+        }
+
+        div_thresholds &div_config()
+        {
+            static div_thresholds config;
+            return config;
+        }
+
+        gcd_thresholds &gcd_config()
+        {
+            static gcd_thresholds config;
+            return config;
+        }
+
+        void divrem(limb_t *q, limb_t *r, const limb_t *a, std::size_t n, const limb_t *d, std::size_t m)
+        {
+            std::size_t threshold = div_config().newton;
+            if (m >= threshold && n - m + 1 >= threshold)
+            {
+                divrem_newton(q, r, a, n, d, m);
+            }
+            else
+            {
+                divrem_knuth(q, r, a, n, d, m);
+            }
+        }
+
+        scratch_vector reciprocal(const limb_t *d, std::size_t k)
+        {
+            if (k < std::max<std::size_t>(div_config().newton, 2))
+            {
+                scratch_vector num(2 * k + 1, 0), x(k + 2), rem(k);
+                num[2 * k] = 1;
+                divrem_knuth(x.data(), rem.data(), num.data(), 2 * k + 1, d, k);
+                x.resize(normalized_size(x.data(), x.size()));
+                return x;
+            }
+
+            // the reciprocal of the top half of d, scaled up, is right to about
+            // half the limbs. one newton step x += x (B^2k - d x) / B^2k then
+            // gets it to within a few units. the step never overshoots, so
+            // rounding it down keeps x at or below the true reciprocal
+            std::size_t h = (k + 1) / 2;
+            scratch_vector v = reciprocal(d + k - h, h);
+
+            // x = v B^(k-h) has k - h zero limbs, so work with v directly:
+            // B^2k - d x = e B^(k-h) for e = B^(k+h) - d v, and the correction
+            // x e B^(k-h) / B^2k is v e / B^2h
+            scratch_vector e(k + h + 1, 0), p = mul_vector(d, k, v.data(), v.size());
+            e[k + h] = 1;
+            bool over = magnitude_sub(e, p);
+            scratch_vector t = mul_vector(v.data(), v.size(), e.data(), e.size());
+            t.erase(t.begin(), t.begin() + std::min(t.size(), 2 * h));
+
+            scratch_vector x(k - h, 0);
+            x.insert(x.end(), v.begin(), v.end());
+            if (over)
+            {
+                magnitude_add(t, scratch_vector(1, 1));
+                magnitude_sub(x, t);
+            }
+            else
+            {
+                magnitude_add(x, t);
+            }
+
+            return x;
+        }
+
+        void divrem_newton(limb_t *q, limb_t *r, const limb_t *a, std::size_t n, const limb_t *d, std::size_t m)
+        {
+            std::size_t qn = n - m + 1;
+            scratch_vector av(a, a + n), dv(d, d + m), one(1, 1);
+            av.resize(normalized_size(av.data(), n));
+
+            // a short quotient only depends on the top limbs of a and d, so
+            // divide those and correct the estimate with the full divisor
+            if (qn + 2 < m)
+            {
+                std::size_t cut = m - qn - 2;
+                scratch_vector qv(qn, 0), rem(m - cut);
+                divrem(qv.data(), rem.data(), a + cut, n - cut, d + cut, m - cut);
+                qv.resize(normalized_size(qv.data(), qn));
+
+                scratch_vector p = mul_vector(qv.data(), qv.size(), d, m);
+                while (cmp_vector(p, av) > 0)
+                {
+                    magnitude_sub(qv, one);
+                    magnitude_sub(p, dv);
+                }
+
+                magnitude_sub(av, p);
+                while (cmp_vector(av, dv) >= 0)
+                {
+                    magnitude_add(qv, one);
+                    magnitude_sub(av, dv);
+                }
+
+                std::fill(q, q + qn, 0);
+                std::copy(qv.begin(), qv.end(), q);
+                std::fill(r, r + m, 0);
+                std::copy(av.begin(), av.end(), r);
+                return;
+            }
+
+            // normalize so the top bit of the divisor is set
+            int s = count_leading_zeros(d[m - 1]);
+            scratch_vector dn(d, d + m), an(a, a + n);
+            an.push_back(0);
+            if (s)
+            {
+                lshift(dn.data(), d, m, s);
+                an[n] = lshift(an.data(), a, n, s);
+            }
+
+            // divide m limb blocks of a from the top. each partial dividend is
+            // below dn B^m, so the quotient estimate floor(floor(u / B^(m-1)) v
+            // / B^(m+1)) is never too big and only a few units too small, which
+            // the correction loop adds back
+            scratch_vector v = reciprocal(dn.data(), m), dnv = dn, rem;
+            dnv.resize(normalized_size(dnv.data(), m));
+            std::size_t blocks = (n + 1 + m - 1) / m;
+            scratch_vector quot(blocks * m, 0);
+
+            for (std::size_t i = blocks; i-- > 0;)
+            {
+                std::size_t lo = i * m, hi = std::min(n + 1, lo + m);
+                scratch_vector u(an.begin() + lo, an.begin() + hi);
+                u.resize(m, 0);
+                u.insert(u.end(), rem.begin(), rem.end());
+                u.resize(normalized_size(u.data(), u.size()));
+
+                scratch_vector qi;
+                if (u.size() >= m)
+                {
+                    qi = mul_vector(u.data() + m - 1, u.size() - m + 1, v.data(), v.size());
+                    qi.erase(qi.begin(), qi.begin() + std::min(qi.size(), m + 1));
+                }
+
+                scratch_vector p = mul_vector(qi.data(), qi.size(), dnv.data(), dnv.size());
+                magnitude_sub(u, p);
+                while (cmp_vector(u, dnv) >= 0)
+                {
+                    magnitude_add(qi, one);
+                    magnitude_sub(u, dnv);
+                }
+
+                std::copy(qi.begin(), qi.end(), quot.begin() + lo);
+                rem.swap(u);
+            }
+
+            std::copy(quot.begin(), quot.begin() + qn, q);
+
+            // the remainder is left normalized, shift it back
+            rem.resize(m, 0);
+            if (s)
+            {
+                rshift(r, rem.data(), m, s);
+            }
+            else
+            {
+                std::copy(rem.begin(), rem.end(), r);
+            }
+        }
+
+        const std::vector<limb_t> &dec_power(std::size_t i)
+        {
+            // a deque keeps references to the powers valid as it grows
+            static std::deque<std::vector<limb_t>> powers;
+            static std::mutex lock;
+
+            std::lock_guard<std::mutex> guard(lock);
+            if (powers.empty())
+            {
+                powers.push_back(std::vector<limb_t>(1, dec_base));
+            }
+            while (powers.size() <= i)
+            {
+                const std::vector<limb_t> &p = powers.back();
+                std::vector<limb_t> sq(2 * p.size());
+                mul(sq.data(), p.data(), p.size(), p.data(), p.size());
+                sq.resize(normalized_size(sq.data(), sq.size()));
+                powers.push_back(std::move(sq));
+            }
+
+            return powers[i];
+        }
+
+        void to_decimal(char *out, std::size_t digits, const limb_t *a, std::size_t n)
+        {
+            n = normalized_size(a, n);
+            if (n <= dec_basecase)
+            {
+                // peel off dec_digits digits at a time from the right
+                scratch_vector t(a, a + n);
+                char *p = out + digits;
+                while (p > out)
+                {
+                    limb_t chunk = 0;
+                    if (n)
+                    {
+                        chunk = divrem_1(t.data(), t.data(), n, dec_base);
+                        n = normalized_size(t.data(), n);
+                    }
+
+                    for (int j = 0; j < dec_digits && p > out; j++)
+                    {
+                        *--p = '0' + (char)(chunk % 10);
+                        chunk /= 10;
+                    }
+                }
+
+                return;
+            }
+
+            // split at the largest cached power with at most half the limbs of
+            // a, the quotient gives the high digits and the remainder the low
+            std::size_t i = 0;
+            while (dec_power(i + 1).size() * 2 <= n)
+            {
+                i++;
+            }
+
+            const std::vector<limb_t> &d = dec_power(i);
+            std::size_t m = d.size(), low = (std::size_t)dec_digits << i;
+            scratch_vector q(n - m + 1), r(m);
+            if (m == 1)
+            {
+                r[0] = divrem_1(q.data(), a, n, d[0]);
+            }
+            else
+            {
+                divrem(q.data(), r.data(), a, n, d.data(), m);
+            }
+
+            to_decimal(out, digits - low, q.data(), q.size());
+            to_decimal(out + digits - low, low, r.data(), r.size());
+        }
+
+        scratch_vector from_decimal(const char *s, std::size_t digits)
+        {
+            scratch_vector r;
+            if (digits <= dec_basecase * dec_digits)
+            {
+                // read the digits in chunks of dec_digits, most significant
+                // first, so each chunk is one multiply and add over the limbs
+                r.reserve(digits / dec_digits + 1);
+                std::size_t k = digits % dec_digits;
+                if (!k)
+                {
+                    k = dec_digits;
+                }
+
+                for (std::size_t i = 0; i < digits; i += k, k = dec_digits)
+                {
+                    limb_t chunk = digits_value(s + i, (int)k);
+                    limb_t c = mul_1(r.data(), r.data(), r.size(), dec_base);
+                    c += add_1(r.data(), r.data(), r.size(), chunk);
+                    if (c)
+                    {
+                        r.push_back(c);
+                    }
+                }
+
+                return r;
+            }
+
+            // split off the low digits at the largest cached power below the
+            // length, then combine as high 10^low + low
+            std::size_t i = 0;
+            while (((std::size_t)dec_digits << (i + 1)) < digits)
+            {
+                i++;
+            }
+
+            std::size_t low = (std::size_t)dec_digits << i;
+            scratch_vector hi = from_decimal(s, digits - low);
+            scratch_vector lo = from_decimal(s + digits - low, low);
+            if (hi.empty())
+            {
+                return lo;
+            }
+
+            const std::vector<limb_t> &d = dec_power(i);
+            r.resize(hi.size() + d.size() + 1, 0);
+            mul(r.data(), hi.data(), hi.size(), d.data(), d.size());
+            add_into(r.data(), r.size(), lo.data(), lo.size());
+            r.resize(normalized_size(r.data(), r.size()));
+
+            return r;
+        }
+
+        const char *scan_digits(const char *first, const char *last)
+        {
+            const char *p = first;
+        #if defined(__AVX2__)
+            // c - '0' is a digit when it is at most 9 as an unsigned byte
+            const __m256i zero = _mm256_set1_epi8('0'), nine = _mm256_set1_epi8(9);
+            for (; last - p >= 32; p += 32)
+            {
+                __m256i d = _mm256_sub_epi8(_mm256_loadu_si256((const __m256i *)p), zero);
+                unsigned m = ~(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(d, nine), nine));
+                if (m)
+                {
+                    return p + __builtin_ctz(m);
+                }
+            }
+        #elif defined(__SSE2__)
+            const __m128i zero = _mm_set1_epi8('0'), nine = _mm_set1_epi8(9);
+            for (; last - p >= 16; p += 16)
+            {
+                __m128i d = _mm_sub_epi8(_mm_loadu_si128((const __m128i *)p), zero);
+                unsigned m = ~(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(d, nine), nine)) & 0xffff;
+                if (m)
+                {
+                    return p + __builtin_ctz(m);
+                }
+            }
+        #endif
+
+            // every byte of w is a digit when its high half is 3, and stays 3
+            // after adding 6. the sum cannot carry between bytes that pass
+            // the first test
+            const std::uint64_t high = 0xf0f0f0f0f0f0f0f0ULL, threes = 0x3030303030303030ULL;
+            for (; last - p >= 8; p += 8)
+            {
+                std::uint64_t w;
+                std::memcpy(&w, p, 8);
+                if ((w & high) != threes || ((w + 0x0606060606060606ULL) & high) != threes)
+                {
+                    break;
+                }
+            }
+
+            while (p != last && (unsigned char)(*p - '0') < 10)
+            {
+                p++;
+            }
+
+            return p;
+        }
+
+        std::uint32_t digits_8(const char *s)
+        {
+        #if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            // the first digit is the low byte. merge neighbouring bytes into
+            // 2 digit values, then those into 4 and 8 digit ones, keeping
+            // every other lane each time
+            std::uint64_t w;
+            std::memcpy(&w, s, 8);
+            w -= 0x3030303030303030ULL;
+            w = (w * 10 + (w >> 8)) & 0x00ff00ff00ff00ffULL;
+            w = (w * 100 + (w >> 16)) & 0x0000ffff0000ffffULL;
+            w = (w * 10000 + (w >> 32)) & 0xffffffffULL;
+            return (std::uint32_t)w;
+        #else
+            std::uint32_t x = 0;
+            for (int i = 0; i < 8; i++)
+            {
+                x = x * 10 + (std::uint32_t)(s[i] - '0');
+            }
+            return x;
+        #endif
+        }
+
+        limb_t digits_value(const char *s, int k)
+        {
+            limb_t x = 0;
+            for (; k >= 8; s += 8, k -= 8)
+            {
+                x = x * 100000000 + digits_8(s);
+            }
+            for (; k > 0; s++, k--)
+            {
+                x = x * 10 + (limb_t)(*s - '0');
+            }
+
+            return x;
+        }
+
+        void get_digits(std::istream &in, std::string &s)
+        {
+            std::streambuf *b = in.rdbuf();
+            char buf[256];
+            std::size_t k = 0;
+            int c = b->sgetc();
+            for (; (unsigned)(c - '0') < 10; c = b->snextc())
+            {
+                buf[k++] = (char)c;
+                if (k == sizeof(buf))
+                {
+                    s.append(buf, k);
+                    k = 0;
+                }
+            }
+
+            s.append(buf, k);
+            if (c == std::char_traits<char>::eof())
+            {
+                in.setstate(std::ios::eofbit);
+            }
+        }
+
+        limb_vector::limb_vector() : store(), len(0), cap(inline_limbs), res(get_memory_resource()) {}
+
+        limb_vector::limb_vector(memory_resource *r) : store(), len(0), cap(inline_limbs), res(r ? r : get_memory_resource()) {}
+
+        limb_vector::limb_vector(const limb_vector &v) : store(), len(0), cap(inline_limbs), res(v.res)
+        {
+            assign(v.data(), v.len);
+        }
+
+        limb_vector::limb_vector(limb_vector &&v) noexcept : store(), len(0), cap(inline_limbs), res(v.res)
+        {
+            swap(v);
+        }
+
+        limb_vector::~limb_vector()
+        {
+            if (cap > inline_limbs)
+            {
+                res->deallocate(store.heap, cap * sizeof(limb_t), alignof(limb_t));
+            }
+        }
+
+        limb_vector &limb_vector::operator=(const limb_vector &v)
+        {
+            if (this != &v)
+            {
+                assign(v.data(), v.len);
+            }
+
+            return *this;
+        }
+
+        limb_vector &limb_vector::operator=(limb_vector &&v)
+        {
+            // v is left empty, holding the old buffer of this one. a buffer
+            // from another resource is copied instead, so each keeps its own
+            if (this == &v)
+            {
+                return *this;
+            }
+
+            if (res == v.res || res->is_equal(*v.res))
+            {
+                len = 0;
+                swap(v);
+            }
+            else
+            {
+                assign(v.data(), v.len);
+                v.clear();
+            }
+
+            return *this;
+        }
+
+        std::size_t limb_vector::size() const
+        {
+            return len;
+        }
+
+        bool limb_vector::empty() const
+        {
+            return !len;
+        }
+
+        limb_t *limb_vector::data()
+        {
+            return (cap > inline_limbs) ? store.heap : store.buf;
+        }
+
+        const limb_t *limb_vector::data() const
+        {
+            return (cap > inline_limbs) ? store.heap : store.buf;
+        }
+
+        limb_t &limb_vector::operator[](std::size_t i)
+        {
+            return data()[i];
+        }
+
+        const limb_t &limb_vector::operator[](std::size_t i) const
+        {
+            return data()[i];
+        }
+
+        limb_t &limb_vector::back()
+        {
+            return data()[len - 1];
+        }
+
+        const limb_t &limb_vector::back() const
+        {
+            return data()[len - 1];
+        }
+
+        void limb_vector::reserve(std::size_t n)
+        {
+            if (n <= cap)
+            {
+                return;
+            }
+
+            // grow geometrically so repeated push_back stays linear
+            std::size_t c = std::max(n, 2 * cap);
+            limb_t *p = static_cast<limb_t *>(res->allocate(c * sizeof(limb_t), alignof(limb_t)));
+            std::copy(data(), data() + len, p);
+            if (cap > inline_limbs)
+            {
+                res->deallocate(store.heap, cap * sizeof(limb_t), alignof(limb_t));
+            }
+
+            store.heap = p;
+            cap = c;
+        }
+
+        void limb_vector::resize(std::size_t n, limb_t x)
+        {
+            reserve(n);
+            if (n > len)
+            {
+                std::fill(data() + len, data() + n, x);
+            }
+
+            len = n;
+        }
+
+        void limb_vector::resize_for_overwrite(std::size_t n)
+        {
+            reserve(n);
+            len = n;
+        }
+
+        void limb_vector::push_back(limb_t x)
+        {
+            reserve(len + 1);
+            data()[len++] = x;
+        }
+
+        void limb_vector::clear()
+        {
+            len = 0;
+        }
+
+        void limb_vector::assign(const limb_t *a, std::size_t n)
+        {
+            len = 0;
+            reserve(n);
+            std::copy(a, a + n, data());
+            len = n;
+        }
+
+        void limb_vector::swap(limb_vector &v) noexcept
+        {
+            // the union holds either the inline limbs or the heap pointer, so
+            // swapping it whole works for every mix of the two
+            std::swap(store, v.store);
+            std::swap(len, v.len);
+            std::swap(cap, v.cap);
+            std::swap(res, v.res);
+        }
+
+        memory_resource *limb_vector::resource() const
+        {
+            return res;
+        }
+
+        bool operator==(const limb_vector &a, const limb_vector &b)
+        {
+            return a.len == b.len && std::equal(a.data(), a.data() + a.len, b.data());
+        }
+
+        std::vector<std::uint64_t> primes_upto(std::uint64_t n)
+        {
+            std::vector<std::uint64_t> p;
+            if (n < 2)
+            {
+                return p;
+            }
+
+            // sieve of eratosthenes over the odd numbers, 2i + 1 at index i
+            p.push_back(2);
+            std::vector<bool> composite((n - 1) / 2 + 1);
+            for (std::uint64_t i = 1; 2 * i + 1 <= n; i++)
+            {
+                if (composite[i])
+                {
+                    continue;
+                }
+
+                std::uint64_t q = 2 * i + 1;
+                p.push_back(q);
+                if (q > n / q)
+                {
+                    continue;
+                }
+
+                // odd multiples of q from q^2, 2q apart
+                for (std::uint64_t j = q * q / 2; 2 * j + 1 <= n; j += q)
+                {
+                    composite[j] = true;
+                }
+            }
+
+            return p;
+        }
+
+        std::uint64_t legendre(std::uint64_t n, std::uint64_t p)
+        {
+            std::uint64_t e = 0;
+            while (n)
+            {
+                n /= p;
+                e += n;
+            }
+
+            return e;
+        }
+
+        ubint product(const std::uint64_t *v, std::size_t n)
+        {
+            // multiply neighbours together while they fit a limb
+            const limb_t max = ~limb_t(0);
+            std::vector<std::uint64_t> packed;
+            std::uint64_t acc = 1;
+            for (std::size_t i = 0; i < n; i++)
+            {
+                if (acc <= max / v[i])
+                {
+                    acc *= v[i];
+                }
+                else
+                {
+                    packed.push_back(acc);
+                    acc = v[i];
+                }
+            }
+            packed.push_back(acc);
+
+            return product_tree(packed.data(), packed.size());
+        }
+
+        ubint product_tree(const std::uint64_t *v, std::size_t n)
+        {
+            const std::size_t leaves = 16;
+            if (n <= leaves)
+            {
+                ubint r = 1;
+                limb_vector &x = ubint_access::limbs(r);
+                scratch_vector t;
+                for (std::size_t i = 0; i < n; i++)
+                {
+                    // a value wider than a limb, with 32 bit limbs, takes two
+                    limb_t w[2] = {(limb_t)v[i], (limb_t)(v[i] >> (limb_bits - 1) >> 1)};
+                    std::size_t m = x.size(), k = w[1] ? 2 : 1;
+                    t.resize(m + k);
+                    mul(t.data(), x.data(), m, w, k);
+                    x.assign(t.data(), m + k);
+                    ubint_access::trim(r);
+                }
+
+                return r;
+            }
+
+            // the halves allocate their limbs on the pool threads, so they only
+            // run there when the limbs come from the thread safe default
+            bool parallel = use_parallel(n) && resource_config() == default_resource();
+            std::size_t h = n / 2;
+            ubint half[2];
+            parallel_for(parallel, 2, 1, [&](std::size_t lo, std::size_t hi)
+            {
+                for (std::size_t i = lo; i < hi; i++)
+                {
+                    half[i] = i ? product_tree(v + h, n - h) : product_tree(v, h);
+                }
+            });
+
+            return std::move(half[0]) * half[1];
+        }
+
+        ubint prime_power_product(const std::vector<std::uint64_t> &p, const std::vector<std::uint64_t> &e)
+        {
+            std::uint64_t top = 0;
+            for (std::size_t i = 0; i < e.size(); i++)
+            {
+                top = std::max(top, e[i]);
+            }
+
+            ubint r = 1;
+            std::vector<std::uint64_t> f;
+            for (int b = 63; b >= 0; b--)
+            {
+                if (!(top >> b))
+                {
+                    continue;
+                }
+
+                f.clear();
+                for (std::size_t i = 0; i < p.size(); i++)
+                {
+                    if ((e[i] >> b) & 1)
+                    {
+                        f.push_back(p[i]);
+                    }
+                }
+
+                r *= r;
+                r *= product(f.data(), f.size());
+            }
+
+            return r;
+        }
+
+        std::size_t bit_length(const ubint &a)
+        {
+            const limb_vector &x = ubint_access::limbs(a);
+            return x.empty() ? 0 : x.size() * limb_bits - count_leading_zeros(x.back());
+        }
+
+        std::size_t trailing_zeros(const ubint &a)
+        {
+            const limb_vector &x = ubint_access::limbs(a);
+            std::size_t i = 0;
+            while (!x[i])
+            {
+                i++;
+            }
+
+            std::size_t t = i * limb_bits;
+            for (limb_t w = x[i]; !(w & 1); w >>= 1)
+            {
+                t++;
+            }
+
+            return t;
+        }
+
+        double log2_approx(const ubint &a)
+        {
+            // the top two limbs hold more bits than a double keeps
+            const limb_vector &x = ubint_access::limbs(a);
+            std::size_t n = x.size();
+            if (n == 1)
+            {
+                return std::log2((double)x[0]);
+            }
+
+            double top = std::ldexp((double)x[n - 1], limb_bits) + (double)x[n - 2];
+            return std::log2(top) + (double)(n - 2) * limb_bits;
+        }
+
+        ubint pow_ui(const ubint &x, std::uint64_t e)
+        {
+            ubint r(1ULL, x.resource());
+            int b = 63;
+            while (b >= 0 && !((e >> b) & 1))
+            {
+                b--;
+            }
+
+            for (; b >= 0; b--)
+            {
+                r *= r;
+                if ((e >> b) & 1)
+                {
+                    r *= x;
+                }
+            }
+
+            return r;
+        }
+
+        const ubint &pow10(std::size_t k)
+        {
+            // the power outlives whatever resource is set when it is made,
+            // so it always comes from new and delete
+            struct power
+            {
+                std::size_t k = 0;
+                ubint p = ubint(1ULL, default_resource());
+            };
+            thread_local power last;
+
+            if (last.k != k)
+            {
+                last.p = pow_ui(ubint(10ULL, default_resource()), k);
+                last.k = k;
+            }
+
+            return last.p;
+        }
+
+        void truncate(ubint &a, std::size_t k)
+        {
+            limb_vector &x = ubint_access::limbs(a);
+            std::size_t n = k / limb_bits;
+            int s = k % limb_bits;
+            if (x.size() <= n)
+            {
+                return;
+            }
+
+            if (s)
+            {
+                x.resize(n + 1);
+                x[n] &= ((limb_t)1 << s) - 1;
+            }
+            else
+            {
+                x.resize(n);
+            }
+            ubint_access::trim(a);
+        }
+
+        bool square_candidate(const ubint &a)
+        {
+            // a mod 64 and mod the product of the odd moduli, which fits in 32
+            // bits. together they pass about one non square in 2700
+            static const unsigned moduli[] = {63, 11, 13, 17, 19, 23, 29};
+            static const limb_t product = 1940907969;
+
+            // bit r of a mask is set when r is a square mod its modulus
+            static const struct squares
+            {
+                std::uint64_t low, masks[7];
+
+                squares() : low(0), masks()
+                {
+                    for (unsigned i = 0; i < 64; i++)
+                    {
+                        low |= (std::uint64_t)1 << (i * i % 64);
+                    }
+                    for (int j = 0; j < 7; j++)
+                    {
+                        for (unsigned i = 0; i < moduli[j]; i++)
+                        {
+                            masks[j] |= (std::uint64_t)1 << (i * i % moduli[j]);
+                        }
+                    }
+                }
+            } table;
+
+            const limb_vector &x = ubint_access::limbs(a);
+            if (x.empty())
+            {
+                return true;
+            }
+
+            if (!((table.low >> (x[0] & 63)) & 1))
+            {
+                return false;
+            }
+
+            limb_t r = divrem_1(nullptr, x.data(), x.size(), product);
+            for (int j = 0; j < 7; j++)
+            {
+                if (!((table.masks[j] >> (r % moduli[j])) & 1))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        ubint root_2adic(const ubint &a, std::uint64_t p, std::size_t k)
+        {
+            // r = a^(-1/p) by newton's iteration r += r (1 - a r^p) / p, where
+            // dividing by the odd p is exact mod 2^j. each step doubles the
+            // correct low bits, from r = 1 which is right mod 2. the root is
+            // then a r^(p - 1)
+            auto pow64 = [](std::uint64_t x, std::uint64_t e)
+            {
+                std::uint64_t r = 1;
+                for (; e; e >>= 1, x *= x)
+                {
+                    if (e & 1)
+                    {
+                        r *= x;
+                    }
+                }
+                return r;
+            };
+
+            auto pow_low = [](const ubint &x, std::uint64_t e, std::size_t j)
+            {
+                ubint r = 1;
+                int b = 63;
+                while (b >= 0 && !((e >> b) & 1))
+                {
+                    b--;
+                }
+
+                for (; b >= 0; b--)
+                {
+                    r *= r;
+                    truncate(r, j);
+                    if ((e >> b) & 1)
+                    {
+                        r *= x;
+                        truncate(r, j);
+                    }
+                }
+                return r;
+            };
+
+            // the low 64 bits first, in machine words
+            const limb_vector &x = ubint_access::limbs(a);
+            std::uint64_t a0 = x[0];
+            if (limb_bits < 64 && x.size() > 1)
+            {
+                a0 |= (std::uint64_t)x[1] << (limb_bits % 64);
+            }
+
+            std::uint64_t pinv = p, r = 1;
+            for (int i = 0; i < 6; i++)
+            {
+                pinv *= 2 - p * pinv;
+            }
+            for (int i = 0; i < 6; i++)
+            {
+                r += r * (1 - a0 * pow64(r, p)) * pinv;
+            }
+
+            if (k <= 64)
+            {
+                std::uint64_t root = a0 * pow64(r, p - 1);
+                if (k < 64)
+                {
+                    root &= ((std::uint64_t)1 << k) - 1;
+                }
+                return root;
+            }
+
+            ubint rj = r, t, e, low;
+            for (std::size_t j = 64; j < k;)
+            {
+                j = std::min(2 * j, k);
+
+                // t = a r^p - 1, which is zero mod 2^(j / 2)
+                low = a;
+                truncate(low, j);
+                t = pow_low(rj, p, j) * low;
+                truncate(t, j);
+                --t;
+                if (null(t))
+                {
+                    continue;
+                }
+
+                // e = (1 - a r^p) / p mod 2^j, by exact division of all its limbs
+                e = (ubint(1) << j) - t;
+                limb_vector &v = ubint_access::limbs(e);
+                v.resize((j + limb_bits - 1) / limb_bits);
+                divexact_1(v.data(), v.data(), v.size(), (limb_t)p);
+                ubint_access::trim(e);
+                truncate(e, j);
+
+                rj += rj * e;
+                truncate(rj, j);
+            }
+
+            low = a;
+            truncate(low, k);
+            t = pow_low(rj, p - 1, k) * low;
+            truncate(t, k);
+
+            return t;
+        }
+
+        gcd_matrix::gcd_matrix() : u{{1ULL, 0ULL}, {0ULL, 1ULL}} {}
+
+        gcd_matrix1::gcd_matrix1() : u{{1, 0}, {0, 1}} {}
+
+        limb_t gcd_1(limb_t a, limb_t b)
+        {
+            int s = 0;
+            while (!((a | b) & 1))
+            {
+                a >>= 1;
+                b >>= 1;
+                s++;
+            }
+            while (!(a & 1))
+            {
+                a >>= 1;
+            }
+
+            // a stays odd, and b is made odd before each subtraction
+            while (b)
+            {
+            #if defined(__GNUC__)
+                b >>= (sizeof(limb_t) == sizeof(unsigned long long)) ? __builtin_ctzll(b) : __builtin_ctz(b);
+            #else
+                while (!(b & 1))
+                {
+                    b >>= 1;
+                }
+            #endif
+                if (a > b)
+                {
+                    std::swap(a, b);
+                }
+                b -= a;
+            }
+
+            return a << s;
+        }
+
+        dlimb_t gcd_2(dlimb_t a, dlimb_t b)
+        {
+            int s = 0;
+            while (!((a | b) & 1))
+            {
+                a >>= 1;
+                b >>= 1;
+                s++;
+            }
+            while (!(a & 1))
+            {
+                a >>= 1;
+            }
+
+            // once both fit a limb the single limb loop is faster
+            while (b)
+            {
+                if (!(a >> limb_bits) && !(b >> limb_bits))
+                {
+                    return (dlimb_t)gcd_1((limb_t)a, (limb_t)b) << s;
+                }
+
+                while (!(b & 1))
+                {
+                    b >>= 1;
+                }
+                if (a > b)
+                {
+                    std::swap(a, b);
+                }
+                b -= a;
+            }
+
+            return a << s;
+        }
+
+        void gcd_top(const ubint &a, const ubint &b, std::size_t n, dlimb_t &x, dlimb_t &y)
+        {
+            const limb_vector &u = ubint_access::limbs(a), &v = ubint_access::limbs(b);
+            auto limb = [](const limb_vector &w, std::size_t i)
+            {
+                return i < w.size() ? w[i] : 0;
+            };
+
+            x = (dlimb_t)limb(u, n - 1) << limb_bits | limb(u, n - 2);
+            y = (dlimb_t)limb(v, n - 1) << limb_bits | limb(v, n - 2);
+            int c = count_leading_zeros(limb(u, n - 1) | limb(v, n - 1));
+            if (c)
+            {
+                x = x << c | (n > 2 ? limb(u, n - 3) >> (limb_bits - c) : 0);
+                y = y << c | (n > 2 ? limb(v, n - 3) >> (limb_bits - c) : 0);
+            }
+        }
+
+        bool hgcd2(dlimb_t x, dlimb_t y, gcd_matrix1 &m)
+        {
+            // a remainder of x and y is a remainder of a and b while it has
+            // at least two bits in the high limb, as the low limbs of a and b
+            // then cannot change its quotient
+            const int half = limb_bits / 2;
+            dlimb_t low = (dlimb_t)2 << limb_bits;
+            if (x < low || y < low)
+            {
+                return false;
+            }
+
+            // r -= q d for the largest q that keeps r at least bound, adding q
+            // times the other column of m to column c. false once r would
+            // drop below it
+            auto step = [&m](dlimb_t &r, dlimb_t d, dlimb_t bound, int c)
+            {
+                r -= d;
+                if (r < bound)
+                {
+                    return false;
+                }
+
+                limb_t q = 1;
+                bool more = true;
+                if (r > d)
+                {
+                    q = (limb_t)(r / d);
+                    dlimb_t rem = r - q * d;
+                    // one multiple less leaves r above the bound
+                    more = rem >= bound;
+                    if (more)
+                    {
+                        q++;
+                        r = rem;
+                    }
+                }
+
+                m.u[0][c] += q * m.u[0][1 - c];
+                m.u[1][c] += q * m.u[1][1 - c];
+                return more;
+            };
+
+            m = gcd_matrix1();
+            bool turn = x > y;
+            if (!step(turn ? x : y, turn ? y : x, low, turn ? 1 : 0))
+            {
+                return false;
+            }
+
+            // once the larger is below a limb and a half, drop the low half
+            // limb and go on with the bound lowered to match
+            bool shifted = false;
+            for (turn = x >= y; ; turn = !turn)
+            {
+                if (!shifted && !((turn ? x : y) >> (limb_bits + half)))
+                {
+                    x >>= half;
+                    y >>= half;
+                    low = (dlimb_t)2 << half;
+                    shifted = true;
+                }
+
+                if (!step(turn ? x : y, turn ? y : x, low, turn ? 1 : 0))
+                {
+                    return true;
+                }
+            }
+        }
+
+        void gcd_apply(const gcd_matrix1 &m, ubint &a, ubint &b)
+        {
+            limb_vector &x = ubint_access::limbs(a), &y = ubint_access::limbs(b);
+            std::size_t n = std::max(x.size(), y.size());
+            x.resize(n);
+            y.resize(n);
+            scratch_vector t(x.data(), x.data() + n);
+
+            // (a, b) = (u11 a - u01 b, u00 b - u10 a). the results are at most
+            // a and b, so the high limbs cancel
+            mul_1(x.data(), x.data(), n, m.u[1][1]);
+            submul_1(x.data(), y.data(), n, m.u[0][1]);
+            mul_1(y.data(), y.data(), n, m.u[0][0]);
+            submul_1(y.data(), t.data(), n, m.u[1][0]);
+            ubint_access::trim(a);
+            ubint_access::trim(b);
+        }
+
+        void gcd_mul(gcd_matrix &m, const gcd_matrix1 &m1)
+        {
+            for (ubint *row : {m.u[0], m.u[1]})
+            {
+                limb_vector &x = ubint_access::limbs(row[0]), &y = ubint_access::limbs(row[1]);
+                std::size_t n = std::max(x.size(), y.size());
+                x.resize(n + 2);
+                y.resize(n + 2);
+                scratch_vector t(x.data(), x.data() + n);
+
+                // (x, y) = (x u00 + y u10, x u01 + y u11), each below 2 B^(n + 1)
+                dlimb_t h = (dlimb_t)mul_1(x.data(), x.data(), n, m1.u[0][0]) + addmul_1(x.data(), y.data(), n, m1.u[1][0]);
+                x[n] = (limb_t)h;
+                x[n + 1] = (limb_t)(h >> limb_bits);
+                h = (dlimb_t)mul_1(y.data(), y.data(), n, m1.u[1][1]) + addmul_1(y.data(), t.data(), n, m1.u[0][1]);
+                y[n] = (limb_t)h;
+                y[n + 1] = (limb_t)(h >> limb_bits);
+                ubint_access::trim(row[0]);
+                ubint_access::trim(row[1]);
+            }
+        }
+
+        void gcd_mul(gcd_matrix &m, const gcd_matrix &m1)
+        {
+            for (ubint *row : {m.u[0], m.u[1]})
+            {
+                ubint x = row[0] * m1.u[0][0];
+                addmul(x, row[1], m1.u[1][0]);
+                ubint y = row[0] * m1.u[0][1];
+                addmul(y, row[1], m1.u[1][1]);
+                row[0] = std::move(x);
+                row[1] = std::move(y);
+            }
+        }
+
+        bool gcd_divstep(ubint &a, ubint &b, std::size_t s, gcd_matrix *m)
+        {
+            int c = a > b ? 1 : 0;
+            ubint &x = c ? a : b;
+            const ubint &y = c ? b : a;
+            if (s && (a == b || ubint_access::limbs(y).size() <= s))
+            {
+                return false;
+            }
+
+            ubint q, r;
+            divmod(x, y, q, r);
+            if (s && ubint_access::limbs(r).size() <= s)
+            {
+                // one multiple less leaves x above s limbs
+                if (q == 1)
+                {
+                    return false;
+                }
+                --q;
+                r += y;
+            }
+            x = std::move(r);
+
+            if (m)
+            {
+                addmul(m->u[0][c], q, m->u[0][1 - c]);
+                addmul(m->u[1][c], q, m->u[1][1 - c]);
+            }
+
+            return true;
+        }
+
+        bool hgcd_step(ubint &a, ubint &b, std::size_t s, gcd_matrix &m)
+        {
+            const limb_vector &u = ubint_access::limbs(a), &v = ubint_access::limbs(b);
+            std::size_t n = std::max(u.size(), v.size());
+
+            // with a single limb above s the top limbs are taken unshifted, so
+            // no bits from at or below limb s - 1 decide the steps
+            dlimb_t x, y;
+            if (n == s + 1)
+            {
+                limb_t xh = u.size() == n ? u[n - 1] : 0, yh = v.size() == n ? v[n - 1] : 0;
+                x = (dlimb_t)xh << limb_bits | (u.size() > n - 2 ? u[n - 2] : 0);
+                y = (dlimb_t)yh << limb_bits | (v.size() > n - 2 ? v[n - 2] : 0);
+            }
+            else
+            {
+                gcd_top(a, b, n, x, y);
+            }
+
+            gcd_matrix1 m1;
+            if (hgcd2(x, y, m1))
+            {
+                gcd_apply(m1, a, b);
+                gcd_mul(m, m1);
+                return true;
+            }
+
+            return gcd_divstep(a, b, s, &m);
+        }
+
+        bool hgcd(ubint &a, ubint &b, gcd_matrix &m)
+        {
+            auto size = [&a, &b]()
+            {
+                return std::max(ubint_access::limbs(a).size(), ubint_access::limbs(b).size());
+            };
+
+            std::size_t n = size(), s = n / 2 + 1;
+            if (n <= s)
+            {
+                return false;
+            }
+
+            // reduce the top half on its own, which takes a and b down to
+            // about 3n / 4 limbs, then the top of what is left, which takes
+            // them to about n / 2. lehmer steps do the rest
+            bool reduced = false;
+            if (n >= gcd_config().hgcd_recurse)
+            {
+                reduced = hgcd_reduce(a, b, n / 2, m);
+
+                while (size() > 3 * n / 4 + 1)
+                {
+                    if (!hgcd_step(a, b, s, m))
+                    {
+                        return reduced;
+                    }
+                    reduced = true;
+                }
+
+                std::size_t k = size();
+                gcd_matrix m1;
+                if (k > s + 2 && hgcd_reduce(a, b, 2 * s - k + 1, m1))
+                {
+                    gcd_mul(m, m1);
+                    reduced = true;
+                }
+            }
+
+            while (hgcd_step(a, b, s, m))
+            {
+                reduced = true;
+            }
+
+            return reduced;
+        }
+
+        bool hgcd_reduce(ubint &a, ubint &b, std::size_t p, gcd_matrix &m)
+        {
+            std::size_t k = p * limb_bits;
+            ubint x = a >> k, y = b >> k;
+            if (!hgcd(x, y, m))
+            {
+                return false;
+            }
+
+            // (a, b) = m^-1 (a, b), where the top parts are already x and y:
+            // a = x B^p + u11 a0 - u01 b0 and b = y B^p + u00 b0 - u10 a0
+            // for the low parts a0 and b0, which the half gcd bounds keep
+            // from going negative
+            truncate(a, k);
+            truncate(b, k);
+            x <<= k;
+            y <<= k;
+            addmul(x, m.u[1][1], a);
+            submul(x, m.u[0][1], b);
+            addmul(y, m.u[0][0], b);
+            submul(y, m.u[1][0], a);
+            a = std::move(x);
+            b = std::move(y);
+
+            return true;
+        }
+
+        void gcd_reduce(ubint &a, ubint &b, gcd_matrix *m)
+        {
+            const limb_vector &u = ubint_access::limbs(a), &v = ubint_access::limbs(b);
+            while (!u.empty() && !v.empty())
+            {
+                std::size_t n = std::max(u.size(), v.size());
+                if (std::min(u.size(), v.size()) + 1 < n)
+                {
+                    // the top limbs of the shorter are zero, so divide
+                    gcd_divstep(a, b, 0, m);
+                }
+                else if (n >= gcd_config().hgcd)
+                {
+                    // the half gcd of the top third takes n down by about a
+                    // sixth for the cost of a few products
+                    gcd_matrix h;
+                    if (hgcd_reduce(a, b, 2 * n / 3, h))
+                    {
+                        if (m)
+                        {
+                            gcd_mul(*m, h);
+                        }
+                    }
+                    else
+                    {
+                        gcd_divstep(a, b, 0, m);
+                    }
+                }
+                else if (n <= 2 && !m)
+                {
+                    dlimb_t x = u[0], y = v[0];
+                    x |= u.size() > 1 ? (dlimb_t)u[1] << limb_bits : 0;
+                    y |= v.size() > 1 ? (dlimb_t)v[1] << limb_bits : 0;
+                    dlimb_t r = gcd_2(x, y);
+                    limb_vector &g = ubint_access::limbs(b);
+                    g.resize(2);
+                    g[0] = (limb_t)r;
+                    g[1] = (limb_t)(r >> limb_bits);
+                    ubint_access::trim(b);
+                    ubint_access::limbs(a).clear();
+                }
+                else if (n == 1)
+                {
+                    // euclid on single limbs, whose matrix fits single limbs
+                    limb_t x = u[0], y = v[0];
+                    gcd_matrix1 m1;
+                    while (x && y)
+                    {
+                        int c = x > y ? 1 : 0;
+                        limb_t q = c ? x / y : y / x;
+                        (c ? x : y) -= q * (c ? y : x);
+                        m1.u[0][c] += q * m1.u[0][1 - c];
+                        m1.u[1][c] += q * m1.u[1][1 - c];
+                    }
+                    a = ubint(x, a.resource());
+                    b = ubint(y, b.resource());
+                    gcd_mul(*m, m1);
+                }
+                else
+                {
+                    dlimb_t x, y;
+                    gcd_top(a, b, n, x, y);
+                    gcd_matrix1 m1;
+                    if (hgcd2(x, y, m1))
+                    {
+                        gcd_apply(m1, a, b);
+                        if (m)
+                        {
+                            gcd_mul(*m, m1);
+                        }
+                    }
+                    else
+                    {
+                        gcd_divstep(a, b, 0, m);
+                    }
+                }
+            }
+        }
+
+        ubint gcdext(const ubint &a, const ubint &b, ubint &s, ubint &t, bool &swapped)
+        {
+            ubint x = a, y = b;
+            gcd_matrix m;
+            gcd_reduce(x, y, &m);
+
+            // (a, b) = m (x, y) with determinant 1, so x = u11 a - u01 b and
+            // y = u00 b - u10 a
+            swapped = null(x);
+            if (null(y) && swapped)
+            {
+                s = 0ULL;
+                t = 0ULL;
+            }
+            else if (swapped)
+            {
+                s = std::move(m.u[1][0]);
+                t = std::move(m.u[0][0]);
+            }
+            else
+            {
+                s = std::move(m.u[1][1]);
+                t = std::move(m.u[0][1]);
+            }
+
+            return swapped ? y : x;
+        }
+    }
+
+#if !defined(__cpp_lib_memory_resource)
+    void *memory_resource::allocate(std::size_t bytes, std::size_t alignment)
+    {
+        return do_allocate(bytes, alignment);
+    }
+
+    void memory_resource::deallocate(void *p, std::size_t bytes, std::size_t alignment)
+    {
+        do_deallocate(p, bytes, alignment);
+    }
+
+    bool memory_resource::is_equal(const memory_resource &other) const noexcept
+    {
+        return do_is_equal(other);
+    }
+#endif
+
+    memory_resource *get_memory_resource()
+    {
+        return detail::resource_config();
+    }
+
+    void set_memory_resource(memory_resource *r)
+    {
+        detail::resource_config() = r ? r : detail::default_resource();
+    }
+
+    void release_scratch()
+    {
+        detail::scratch().release();
+    }
+
+    memory_resource *get_scratch_resource()
+    {
+        return detail::spill_config().resource;
+    }
+
+    void set_scratch_resource(memory_resource *r, std::size_t bytes)
+    {
+        detail::spill_config() = {r, r ? bytes : 0};
+    }
+
+    mul_thresholds get_mul_thresholds()
+    {
+        return detail::mul_config();
+    }
+
+    void set_mul_thresholds(const mul_thresholds &t)
+    {
+        // below these sizes the recursive algorithms cannot split their operands
+        detail::mul_config().karatsuba = std::max<std::size_t>(t.karatsuba, 2);
+        detail::mul_config().toom3 = std::max<std::size_t>(t.toom3, 3);
+        detail::mul_config().toom4 = std::max<std::size_t>(t.toom4, 4);
+        detail::mul_config().ntt = std::max<std::size_t>(t.ntt, 1);
+        detail::mul_config().parallel = std::max<std::size_t>(t.parallel, 1);
+    }
+
+    std::size_t get_thread_count()
+    {
+        return detail::thread_count();
+    }
+
+    void set_thread_count(std::size_t n)
+    {
+        detail::thread_config() = n;
+    }
+
+    limb_kernels get_limb_kernels()
+    {
+        return detail::kernel_config().set;
+    }
+
+    void set_limb_kernels(limb_kernels k)
+    {
+        detail::kernel_config() = detail::make_kernels(k);
+    }
+
+    div_thresholds get_div_thresholds()
+    {
+        return detail::div_config();
+    }
+
+    void set_div_thresholds(const div_thresholds &t)
+    {
+        detail::div_config().newton = std::max<std::size_t>(t.newton, 3);
+    }
+
+    gcd_thresholds get_gcd_thresholds()
+    {
+        return detail::gcd_config();
+    }
+
+    void set_gcd_thresholds(const gcd_thresholds &t)
+    {
+        detail::gcd_config().hgcd = std::max<std::size_t>(t.hgcd, 8);
+        detail::gcd_config().hgcd_recurse = std::max<std::size_t>(t.hgcd_recurse, 8);
+    }
+
+    ubint::ubint(unsigned long long n) : ubint(n, nullptr) {}
+
+    ubint::ubint(const std::string& s) : ubint(s, nullptr) {}
+
+    ubint::ubint(unsigned long long n, memory_resource *r) : limbs(r)
+    {
+        while (n)
+        {
+            limbs.push_back((detail::limb_t)n);
+            // shift in two steps, as a full width shift is undefined
+            n >>= detail::limb_bits - 1;
+            n >>= 1;
+        }
+    }
+
+    ubint::ubint(const std::string& s, memory_resource *r) : limbs(r)
+    {
+        std::size_t n = s.size();
+        if (detail::scan_digits(s.data(), s.data() + n) != s.data() + n)
+        {
+            throw std::invalid_argument("input must be a number");
+        }
+
+        detail::scratch_vector v = detail::from_decimal(s.data(), n);
+        limbs.assign(v.data(), v.size());
+    }
+
+    ubint::ubint(const char * s) : ubint(std::string(s)) {}
+
+    ubint::ubint(const char * s, memory_resource *r) : ubint(std::string(s), r) {}
+
+    ubint::ubint(const ubint &u) : limbs(u.limbs) {}
+
+    ubint::ubint(ubint &&u) noexcept : limbs(std::move(u.limbs)) {}
+
+    ubint::ubint(const ubint &u, memory_resource *r) : limbs(r)
+    {
+        limbs = u.limbs;
+    }
+
+    memory_resource *ubint::resource() const
+    {
+        return limbs.resource();
+    }
+
+    void ubint::trim()
+    {
+        limbs.resize(detail::normalized_size(limbs.data(), limbs.size()));
+    }
+
+    std::ostream &operator<<(std::ostream &out, const ubint &a)
+    {
+        out << a.value();
+
+        return out;
+    }
+
+    std::istream &operator>>(std::istream &in, ubint &a)
+    {
+        // skips leading white space, as for the built in types
+        std::istream::sentry ok(in);
+        if (!ok)
+        {
+            return in;
+        }
+
+        std::string s;
+        detail::get_digits(in, s);
+        if (s.empty())
+        {
+            in.setstate(std::ios::failbit);
+            return in;
+        }
+
+        from_chars(s.data(), s.data() + s.size(), a);
+
+        return in;
+    }
+
+    std::from_chars_result from_chars(const char *first, const char *last, ubint &a)
+    {
+        const char *end = detail::scan_digits(first, last);
+        if (end == first)
+        {
+            return {first, std::errc::invalid_argument};
+        }
+
+        const char *p = first;
+        while (p != end && *p == '0')
+        {
+            p++;
+        }
+
+        detail::scratch_vector v = detail::from_decimal(p, end - p);
+        a.limbs.assign(v.data(), v.size());
+
+        return {end, std::errc()};
+    }
+
+    bool null(const ubint &a)
+    {
+        return a.limbs.empty();
+    }
+
+    int length(const ubint &a)
+    {
+        std::size_t bits = detail::bit_length(a);
+        if (bits <= 1)
+        {
+            return 1;
+        }
+
+        // 2^(bits - 1) <= a has floor((bits - 1) log10(2)) + 1 digits, and a
+        // has at most two more. the estimate is nudged down so that rounding
+        // cannot make it too high, the compares then settle it, usually
+        // with one
+        double x = (double)(bits - 1) * 0.30102999566398120;
+        std::size_t d = (std::size_t)std::max(x - 1e-6, 0.0) + 1;
+        while (a >= detail::pow10(d))
+        {
+            d++;
+        }
+
+        return (int)d;
+    }
+
+    int ubint::operator[](const int index) const
+    {
+        // digit i is (a / 10^i) mod 10, and exists if a >= 10^i. digit 0 of
+        // zero is 0
+        if (index < 0 || (index > 0 && *this < detail::pow10(index)))
+        {
+            throw std::out_of_range("index out of range");
+        }
+
+        ubint q = *this / detail::pow10(index);
+        return (int)detail::divrem_1(q.limbs.data(), q.limbs.data(), q.limbs.size(), 10);
+    }
+
+    std::string ubint::value() const
+    {
+        if (limbs.empty())
+        {
+            return "0";
+        }
+
+        // bits log10(2) + 1 digits is enough, one more covers rounding in
+        // the estimate. the leading zeros are dropped after
+        std::size_t n = limbs.size();
+        std::size_t bits = n * detail::limb_bits - detail::count_leading_zeros(limbs.back());
+        std::size_t digits = (std::size_t)(bits * 0.30102999566398120) + 2;
+
+        std::string val(digits, '0');
+        detail::to_decimal(&val[0], digits, limbs.data(), n);
+        val.erase(0, val.find_first_not_of('0'));
+
+        return val;
+    }
+
+    ubint &ubint::operator=(const ubint &a)
+    {
+        limbs = a.limbs;
+        return (*this);
+    }
+
+    ubint &ubint::operator=(ubint &&a)
+    {
+        limbs = std::move(a.limbs);
+        return (*this);
+    }
+
+    ubint &ubint::operator++()
+    {
+        if (detail::add_1(limbs.data(), limbs.data(), limbs.size(), 1))
+        {
+            limbs.push_back(1);
+        }
+
+        return (*this);
+    }
+
+    ubint ubint::operator++(int temp)
+    {
+        ubint result = *this;
+
+        if (temp != 0)
+        {
+            (*this) += temp;
+        } else {
+            ++(*this);
+        }
+
+        return result;
+    }
+
+    ubint &ubint::operator--()
+    {
+        if (null(*this))
+        {
+            throw std::underflow_error("underflow");
+        }
+
+        detail::sub_1(limbs.data(), limbs.data(), limbs.size(), 1);
+        trim();
+
+        return *this;
+    }
+
+    ubint ubint::operator--(int temp)
+    {
+        ubint result = *this;
+
+        if (temp != 0)
+        {
+            (*this) -= temp;
+        } else {
+            --(*this);
+        }
+
+        return result;
+    }
+
+    ubint &operator+=(ubint &a, const ubint &b)
+    {
+        // n = length(a), m = length(b) in limbs
+        std::size_t n = a.limbs.size(), m = b.limbs.size();
+        if (n == 1 && m == 1)
+        {
+            // single limbs, add and carry into a second limb
+            // b may be a, so read it before writing
+            detail::limb_t x = b.limbs[0], t = a.limbs[0] + x;
+            a.limbs[0] = t;
+            if (t < x)
+            {
+                a.limbs.push_back(1);
+            }
+
+            return a;
+        }
+
+        if (m > n)
+        {
+            a.limbs.resize(m, 0);
+        }
+
+        detail::limb_t c = detail::add_n(a.limbs.data(), a.limbs.data(), b.limbs.data(), m);
+        if (c && n > m)
+        {
+            c = detail::add_1(a.limbs.data() + m, a.limbs.data() + m, n - m, c);
+        }
+
+        if (c)
+        {
+            a.limbs.push_back(c);
+        }
+
+        return a;
+    }
+
+    ubint operator+(const ubint &a, const ubint &b)
+    {
+        // add into a fresh result in one pass over a and b, rather than
+        // copying a and adding b to the copy, which matters most when the
+        // numbers are larger than the cache or live in a mapped file
+        const ubint &x = a.limbs.size() < b.limbs.size() ? b : a;
+        const ubint &y = a.limbs.size() < b.limbs.size() ? a : b;
+        std::size_t n = x.limbs.size(), m = y.limbs.size();
+
+        ubint tmp(0ULL, a.resource());
+        tmp.limbs.reserve(n + 1);
+        tmp.limbs.resize_for_overwrite(n);
+        detail::limb_t c = detail::add_n(tmp.limbs.data(), x.limbs.data(), y.limbs.data(), m);
+        c = detail::add_1(tmp.limbs.data() + m, x.limbs.data() + m, n - m, c);
+        if (c)
+        {
+            tmp.limbs.push_back(c);
+        }
+
+        return tmp;
+    }
+
+    ubint operator+(ubint &&a, const ubint &b)
+    {
+        a += b;
+        return std::move(a);
+    }
+
+    ubint operator+(const ubint &a, ubint &&b)
+    {
+        b += a;
+        return std::move(b);
+    }
+
+    ubint operator+(ubint &&a, ubint &&b)
+    {
+        a += b;
+        return std::move(a);
+    }
+
+    ubint operator-(const ubint &a, const ubint &b)
+    {
+        if (a < b)
+        {
+            throw std::underflow_error("underflow. a cannot be less than b");
+        }
+
+        // subtract into a fresh result in one pass, as for addition
+        std::size_t n = a.limbs.size(), m = b.limbs.size();
+
+        ubint tmp(0ULL, a.resource());
+        tmp.limbs.resize_for_overwrite(n);
+        detail::limb_t c = detail::sub_n(tmp.limbs.data(), a.limbs.data(), b.limbs.data(), m);
+        detail::sub_1(tmp.limbs.data() + m, a.limbs.data() + m, n - m, c);
+        tmp.trim();
+
+        return tmp;
+    }
+
+    ubint operator-(ubint &&a, const ubint &b)
+    {
+        a -= b;
+        return std::move(a);
+    }
+
+    ubint &operator-=(ubint &a, const ubint &b)
+    {
+        if (a < b)
+        {
+            throw std::underflow_error("underflow. a cannot be less than b");
+        }
+
+        std::size_t n = a.limbs.size(), m = b.limbs.size();
+
+        detail::limb_t c = detail::sub_n(a.limbs.data(), a.limbs.data(), b.limbs.data(), m);
+        if (c)
+        {
+            detail::sub_1(a.limbs.data() + m, a.limbs.data() + m, n - m, c);
+        }
+        a.trim();
+
+        return a;
+    }
 
     bool operator==(const ubint &a, const ubint &b)
     {
-        return a.digits == b.digits;
+        return a.limbs == b.limbs;
     }
 
     bool operator!=(const ubint &a, const ubint &b)
@@ -397,213 +4766,484 @@ namespace estd
 
     bool operator<(const ubint &a, const ubint &b)
     {
-        int n = length(a), m = length(b);
+        std::size_t n = a.limbs.size(), m = b.limbs.size();
         if (n != m)
         {
             return n < m;
         }
 
-        while (n--)
+        return detail::cmp_n(a.limbs.data(), b.limbs.data(), n) < 0;
+    }
+
+    bool operator<=(const ubint &a, const ubint &b)
+    {
+        return !(a > b);
+    }
+
+    ubint &operator*=(ubint &a, const ubint &b)
+    {
+        if (null(a) || null(b))
+        {
+            a.limbs.clear();
+            return a;
+        }
+
+        std::size_t n = a.limbs.size(), m = b.limbs.size();
+        if (n == 1 && m == 1)
         {
-            if (a.digits[n] != b.digits[n])
+            // single limbs, one double width product
+            detail::dlimb_t p = (detail::dlimb_t)a.limbs[0] * b.limbs[0];
+            a.limbs[0] = (detail::limb_t)p;
+            if (p >> detail::limb_bits)
             {
-                return a.digits[n] < b.digits[n];
+                a.limbs.push_back((detail::limb_t)(p >> detail::limb_bits));
             }
+
+            return a;
         }
 
-        return false;
+        // products that fit inline never touch the heap
+        detail::limb_vector v(a.limbs.resource());
+        v.resize(n + m);
+        detail::mul(v.data(), a.limbs.data(), n, b.limbs.data(), m);
+
+        a.limbs.swap(v);
+        a.trim();
+
+        return a;
     }
 
-    bool operator<=(const ubint &a, const ubint &b)
+    ubint operator*(const ubint &a, const ubint &b)
+    {
+        // build the product directly, a copy of a would only be thrown away
+        ubint tmp(0ULL, a.resource());
+        if (null(a) || null(b))
+        {
+            return tmp;
+        }
+
+        std::size_t n = a.limbs.size(), m = b.limbs.size();
+        tmp.limbs.resize(n + m);
+        detail::mul(tmp.limbs.data(), a.limbs.data(), n, b.limbs.data(), m);
+        tmp.trim();
+
+        return tmp;
+    }
+
+    ubint operator*(ubint &&a, const ubint &b)
+    {
+        a *= b;
+        return std::move(a);
+    }
+
+    ubint operator*(const ubint &a, ubint &&b)
+    {
+        b *= a;
+        return std::move(b);
+    }
+
+    ubint operator*(ubint &&a, ubint &&b)
+    {
+        a *= b;
+        return std::move(a);
+    }
+
+    void ubint::divide(const ubint &a, const ubint &b, ubint *q, ubint *r)
+    {
+        if (null(b))
+        {
+            throw std::invalid_argument("cannot divide by zero");
+        }
+
+        if (a < b)
+        {
+            // the remainder is a itself, copied before q is cleared as q may be a
+            if (r && r != &a)
+            {
+                r->limbs = a.limbs;
+            }
+            if (q)
+            {
+                q->limbs.clear();
+            }
+            return;
+        }
+
+        std::size_t n = a.limbs.size(), m = b.limbs.size(), qn = n - m + 1;
+        if (n == 1)
+        {
+            // single limbs, a plain machine division
+            detail::limb_t x = a.limbs[0], y = b.limbs[0];
+            if (q)
+            {
+                q->limbs.resize(1);
+                q->limbs[0] = x / y;
+            }
+            if (r)
+            {
+                r->limbs.resize(1);
+                r->limbs[0] = x % y;
+                r->trim();
+            }
+            return;
+        }
+
+        // the kernels copy a and b before they write, so the results go
+        // straight into q and r, a included, as neither is longer than a.
+        // only a quotient into b could outgrow the limbs it reads, that and
+        // the outputs that are not wanted go to scratch
+        detail::scratch_vector qs, rs;
+        detail::limb_t *qp, *rp;
+        if (q && q != &b)
+        {
+            if (q != &a)
+            {
+                q->limbs.resize_for_overwrite(qn);
+            }
+            qp = q->limbs.data();
+        }
+        else
+        {
+            qs.resize(qn);
+            qp = qs.data();
+        }
+        if (r)
+        {
+            if (r != &a && r != &b)
+            {
+                r->limbs.resize_for_overwrite(m);
+            }
+            rp = r->limbs.data();
+        }
+        else
+        {
+            rs.resize(m);
+            rp = rs.data();
+        }
+
+        if (m == 1)
+        {
+            rp[0] = detail::divrem_1(qp, a.limbs.data(), n, b.limbs[0]);
+        }
+        else
+        {
+            detail::divrem(qp, rp, a.limbs.data(), n, b.limbs.data(), m);
+        }
+
+        if (q)
+        {
+            if (qs.empty())
+            {
+                q->limbs.resize(qn);
+            }
+            else
+            {
+                q->limbs.assign(qs.data(), qn);
+            }
+            q->trim();
+        }
+        if (r)
+        {
+            r->limbs.resize(m);
+            r->trim();
+        }
+    }
+
+    std::pair<ubint, ubint> divmod(const ubint &a, const ubint &b)
     {
-        return !(a > b);
+        // the results come from the resource of a, as for a / b and a % b
+        std::pair<ubint, ubint> res(ubint(0ULL, a.resource()), ubint(0ULL, a.resource()));
+        ubint::divide(a, b, &res.first, &res.second);
+        return res;
     }
 
-    ubint &operator*=(ubint &a, const ubint &b)
+    void divmod(const ubint &a, const ubint &b, ubint &q, ubint &r)
     {
-        if (null(a) || null(b))
+        if (&q == &r)
         {
-            a = ubint();
-            return a;
+            throw std::invalid_argument("quotient and remainder must be different objects");
         }
 
-        int n = length(a), m = length(b);
-        std::vector<int> v(n + m, 0);
-        for (int i = 0; i < n; i++)
+        ubint::divide(a, b, &q, &r);
+    }
+
+    ubint &muladd(ubint &r, const ubint &a, const ubint &b, const ubint &c)
+    {
+        if (&r == &c)
         {
-            for (int j = 0; j < m; j++)
-            {
-                v[i+j] += (a.digits[i]) * (b.digits[j]);
-            }
+            return addmul(r, a, b);
         }
-        n += m;
-        a.digits.resize(v.size());
-        for (int s, i = 0, t = 0; i < n; i++)
+
+        if (&r == &a || &r == &b)
         {
-            s = t + v[i];
-            v[i] = (s % 10);
-            t = s / 10;
-            a.digits[i] = v[i];
+            ubint t(0ULL, r.resource());
+            muladd(t, a, b, c);
+            r = std::move(t);
+            return r;
         }
 
-        for (int i = n - 1; i >= 1 && !v[i]; i--)
+        if (null(a) || null(b))
         {
-            a.digits.pop_back();
+            r = c;
+            return r;
         }
 
-        return a;
+        // write the product into r, then add c on top of it
+        std::size_t n = a.limbs.size(), m = b.limbs.size();
+        std::size_t rn = std::max(n + m, c.limbs.size()) + 1;
+        r.limbs.clear();
+        r.limbs.resize(rn);
+        detail::mul(r.limbs.data(), a.limbs.data(), n, b.limbs.data(), m);
+        detail::add_into(r.limbs.data(), rn, c.limbs.data(), c.limbs.size());
+        r.trim();
+
+        return r;
     }
 
-    ubint operator*(const ubint &a, const ubint &b)
+    ubint &mulsub(ubint &r, const ubint &a, const ubint &b, const ubint &c)
     {
-        ubint tmp = a;
-        tmp *= b;
-        return tmp;
+        if (&r == &a || &r == &b || &r == &c)
+        {
+            ubint t(0ULL, r.resource());
+            mulsub(t, a, b, c);
+            r = std::move(t);
+            return r;
+        }
+
+        r.limbs.clear();
+        if (!null(a) && !null(b))
+        {
+            std::size_t n = a.limbs.size(), m = b.limbs.size();
+            r.limbs.resize(n + m);
+            detail::mul(r.limbs.data(), a.limbs.data(), n, b.limbs.data(), m);
+            r.trim();
+        }
+
+        r -= c;
+        return r;
     }
 
-    ubint &operator/=(ubint &a, const ubint &b)
+    ubint &addmul(ubint &r, const ubint &a, const ubint &b)
     {
-        if (null(b))
+        if (null(a) || null(b))
         {
-            throw std::invalid_argument("cannot divide by zero");
+            return r;
         }
 
-        if (a < b)
+        if (&r == &a || &r == &b)
         {
-            a = 0ULL;
-            return a;
+            r += a * b;
+            return r;
         }
 
-        if (a == b)
+        // one spare limb above the product keeps the carry inside r
+        std::size_t n = a.limbs.size(), m = b.limbs.size();
+        std::size_t rn = std::max(r.limbs.size(), n + m) + 1;
+        r.limbs.resize(rn, 0);
+        detail::addmul(r.limbs.data(), rn, a.limbs.data(), n, b.limbs.data(), m);
+        r.trim();
+
+        return r;
+    }
+
+    ubint &submul(ubint &r, const ubint &a, const ubint &b)
+    {
+        if (null(a) || null(b))
         {
-            a = 1;
-            return a;
+            return r;
         }
 
-        int i, lgcat = 0, cc;
-        int n = length(a);
-        std::vector<int> cat(n, 0);
-        ubint t;
-        for (i = n - 1; t * 10 + a.digits[i] < b; i--)
+        if (&r == &a || &r == &b)
         {
-            t *= 10;
-            t += a.digits[i];
+            r -= a * b;
+            return r;
         }
 
-        for (; i >= 0; i--)
+        // a * b is at least B^(n + m - 2), so a shorter r is too small
+        std::size_t n = a.limbs.size(), m = b.limbs.size();
+        if (r.limbs.size() + 1 < n + m)
         {
-            t = t * 10 + a.digits[i];
-            for (cc = 9; cc * b > t; cc--);
-            t -= cc * b;
-            cat[lgcat++] = cc;
+            throw std::underflow_error("underflow. r cannot be less than a * b");
         }
 
-        a.digits.resize(cat.size());
-        for (i = 0; i < lgcat; i++)
+        std::size_t rn = std::max(r.limbs.size(), n + m);
+        r.limbs.resize(rn, 0);
+        if (detail::submul(r.limbs.data(), rn, a.limbs.data(), n, b.limbs.data(), m))
         {
-            a.digits[i] = cat[lgcat - i - 1];
+            // a * b was larger after all, add it back to restore r
+            detail::addmul(r.limbs.data(), rn, a.limbs.data(), n, b.limbs.data(), m);
+            r.trim();
+            throw std::underflow_error("underflow. r cannot be less than a * b");
         }
-        a.digits.resize(lgcat);
+        r.trim();
+
+        return r;
+    }
 
+    ubint &operator/=(ubint &a, const ubint &b)
+    {
+        ubint::divide(a, b, &a, nullptr);
         return a;
     }
 
     ubint operator/(const ubint &a, const ubint &b)
     {
-        ubint tmp = a;
-        tmp /= b;
+        // divide into a fresh result, a copy of a would only be overwritten
+        ubint tmp(0ULL, a.resource());
+        ubint::divide(a, b, &tmp, nullptr);
         return tmp;
     }
 
+    ubint operator/(ubint &&a, const ubint &b)
+    {
+        a /= b;
+        return std::move(a);
+    }
+
     ubint operator%(const ubint &a, const ubint &b)
     {
-        ubint tmp = a;
-        tmp %= b;
+        ubint tmp(0ULL, a.resource());
+        ubint::divide(a, b, nullptr, &tmp);
         return tmp;
     }
 
+    ubint operator%(ubint &&a, const ubint &b)
+    {
+        a %= b;
+        return std::move(a);
+    }
+
     ubint &operator%=(ubint &a, const ubint &b)
     {
-        if (null(b))
-        {
-            throw std::invalid_argument("cannot divide by zero");
-        }
+        ubint::divide(a, b, nullptr, &a);
+        return a;
+    }
 
-        if (b == 1 || a == b)
+    bool ubint::shift_count(const ubint &b, std::size_t &count)
+    {
+        // the top limb is non zero, so b fits exactly when its limbs do
+        if (b.limbs.size() * detail::limb_bits > sizeof(std::size_t) * 8)
         {
-            a = 0ULL;
-            return a;
+            return false;
         }
 
-        if (a < b)
+        // shift in two steps so a limb as wide as std::size_t is not shifted
+        // by its full width
+        count = 0;
+        for (std::size_t i = b.limbs.size(); i-- > 0;)
         {
-            return a;
+            count = (count << (detail::limb_bits - 1) << 1) | (std::size_t)b.limbs[i];
         }
 
-        int i, lgcat = 0, cc;
-        int n = length(a);
-        std::vector<int> cat(n, 0);
-        ubint t;
-        for (i = n - 1; t * 10 + a.digits[i] < b; i--)
+        return true;
+    }
+
+    ubint operator<<(const ubint &a, const ubint &b)
+    {
+        ubint tmp = a;
+        tmp <<= b;
+        return tmp;
+    }
+
+    ubint &operator<<=(ubint &a, const ubint &b)
+    {
+        std::size_t count;
+        if (!ubint::shift_count(b, count))
         {
-            t *= 10;
-            t += a.digits[i];
+            if (null(a))
+            {
+                return a;
+            }
+
+            throw std::length_error("bit shift count too large");
         }
 
-        for (; i >= 0; i--)
+        return a <<= count;
+    }
+
+    ubint operator>>(const ubint &a, const ubint &b)
+    {
+        ubint tmp = a;
+        tmp >>= b;
+        return tmp;
+    }
+
+    ubint &operator>>=(ubint &a, const ubint &b)
+    {
+        std::size_t count;
+        if (!ubint::shift_count(b, count))
         {
-            t = t * 10 + a.digits[i];
-            for (cc = 9; cc * b > t;cc--);
-            t -= cc * b;
-            cat[lgcat++] = cc;
+            a.limbs.clear();
+            return a;
         }
 
-        a = t;
-        return a;
+        return a >>= count;
     }
 
-    ubint operator<<(const ubint &a, const ubint &b)
+    ubint operator<<(const ubint &a, std::size_t b)
     {
         ubint tmp = a;
         tmp <<= b;
         return tmp;
     }
 
-    ubint &operator<<=(ubint &a, const ubint &b)
+    ubint &operator<<=(ubint &a, std::size_t b)
     {
-        for (ubint i = 0ULL; i < b; i++)
+        if (null(a) || !b)
+        {
+            return a;
+        }
+
+        // move whole limbs up, then shift the bits within them
+        std::size_t words = b / detail::limb_bits, n = a.limbs.size();
+        int bits = b % detail::limb_bits;
+        a.limbs.resize(n + words + 1, 0);
+
+        detail::limb_t *p = a.limbs.data();
+        if (bits)
+        {
+            p[n + words] = detail::lshift(p + words, p, n, bits);
+        }
+        else
         {
-            a += a;
+            std::copy_backward(p, p + n, p + n + words);
         }
+        std::fill(p, p + words, 0);
 
+        a.trim();
         return a;
     }
 
-    ubint operator>>(const ubint &a, const ubint &b)
+    ubint operator>>(const ubint &a, std::size_t b)
     {
         ubint tmp = a;
         tmp >>= b;
         return tmp;
     }
 
-    ubint &operator>>=(ubint &a, const ubint &b)
+    ubint &operator>>=(ubint &a, std::size_t b)
     {
-        for (ubint i = 0ULL; i < b; i++)
+        std::size_t words = b / detail::limb_bits, n = a.limbs.size();
+        if (words >= n)
         {
-            int add = 0;
-            for (int i = a.digits.size() - 1; i >= 0; i--)
-            {
-                int digit = (a.digits[i] >> 1) + add;
-                add = ((a.digits[i] & 1) * 5);
-                a.digits[i] = digit;
-            }
+            a.limbs.clear();
+            return a;
+        }
 
-            while(a.digits.size() > 1 && !a.digits.back())
-            {
-                a.digits.pop_back();
-            }
+        // move whole limbs down, then shift the bits within them
+        int bits = b % detail::limb_bits;
+        detail::limb_t *p = a.limbs.data();
+        if (bits)
+        {
+            detail::rshift(p, p + words, n - words, bits);
+        }
+        else
+        {
+            std::copy(p + words, p + n, p);
         }
 
+        a.limbs.resize(n - words);
+        a.trim();
         return a;
     }
 
@@ -614,7 +5254,7 @@ namespace estd
 
         while (!null(exp))
         {
-            if (exp[0] & 1)
+            if (exp.limbs[0] & 1)
             {
                 a *= base;
             }
@@ -635,30 +5275,288 @@ namespace estd
 
     ubint sqrt(const ubint &a)
     {
-        ubint left = 1, right = a, v = 1, mid, prod;
-        right >>= 1;
+        ubint s(0ULL, a.resource()), r(0ULL, a.resource());
+        sqrtrem(a, s, r);
+        return s;
+    }
+
+    std::pair<ubint, ubint> sqrtrem(const ubint &a)
+    {
+        std::pair<ubint, ubint> res(ubint(0ULL, a.resource()), ubint(0ULL, a.resource()));
+        sqrtrem(a, res.first, res.second);
+        return res;
+    }
+
+    void sqrtrem(const ubint &a, ubint &s, ubint &r)
+    {
+        if (&s == &r)
+        {
+            throw std::invalid_argument("root and remainder must be different objects");
+        }
+
+        if (null(a))
+        {
+            s = 0ULL;
+            r = 0ULL;
+            return;
+        }
 
-        while(left <= right)
+        std::size_t bits = detail::bit_length(a);
+        if (bits <= 52)
         {
-            mid += left;
-            mid += right;
-            mid >>= 1;
-            prod = (mid * mid);
-            if (prod <= a)
+            // exact in a double, and its root is within one
+            unsigned long long v = a.limbs[0];
+            if (detail::limb_bits < bits)
             {
-                v = mid;
-                ++mid;
-                left = mid;
-            } 
-            else
+                v |= (unsigned long long)a.limbs[1] << (detail::limb_bits % 64);
+            }
+
+            unsigned long long x = (unsigned long long)std::sqrt((double)v);
+            if (x * x > v)
+            {
+                x--;
+            }
+            s = x;
+            r = v - x * x;
+            return;
+        }
+
+        // newton's iteration at doubling precision, as in python's isqrt. x
+        // is within one of the root of the top 2d bits of a, and each step
+        // doubles d with a single division
+        std::size_t c = (bits - 1) / 2, d = 0;
+        int steps = 0;
+        for (std::size_t t = c; t; t >>= 1)
+        {
+            steps++;
+        }
+
+        ubint x = 1;
+        for (int i = steps - 1; i >= 0; i--)
+        {
+            std::size_t e = d;
+            d = c >> i;
+            x = (x << (d - e - 1)) + (a >> (2 * c - e - d + 1)) / x;
+        }
+
+        // x is the root or one above it. (x - 1)^2 = x^2 - 2 (x - 1) - 1
+        ubint sq = x * x;
+        if (sq > a)
+        {
+            --x;
+            sq -= x;
+            sq -= x;
+            --sq;
+        }
+
+        ubint rem = a - sq;
+        s = std::move(x);
+        r = std::move(rem);
+    }
+
+    ubint iroot(const ubint &a, std::size_t k)
+    {
+        if (!k)
+        {
+            throw std::invalid_argument("cannot take the zeroth root");
+        }
+
+        if (k == 1 || null(a))
+        {
+            return a;
+        }
+
+        if (k == 2)
+        {
+            return sqrt(a);
+        }
+
+        // a < 2^bits, so the root is below 2^rb
+        std::size_t bits = detail::bit_length(a);
+        if (k >= bits)
+        {
+            return 1;
+        }
+
+        std::size_t rb = (bits + k - 1) / k;
+        if (rb <= 32)
+        {
+            // within a few of the root from floating point, then corrected
+            ubint x = (unsigned long long)std::exp2(detail::log2_approx(a) / k);
+            while (detail::pow_ui(x + 1ULL, k) <= a)
+            {
+                ++x;
+            }
+            while (detail::pow_ui(x, k) > a)
+            {
+                --x;
+            }
+            return x;
+        }
+
+        // the root of the top bits of a, scaled up, is above the root of a by
+        // about half its bits. newton's iteration from above then only needs
+        // a step or two to reach it
+        std::size_t s = rb / 2;
+        ubint x = (iroot(a >> (k * s), k) + 1ULL) << s;
+        ubint k1 = (unsigned long long)(k - 1), kk = (unsigned long long)k;
+        while (true)
+        {
+            ubint y = (x * k1 + a / detail::pow_ui(x, k - 1)) / kk;
+            if (y >= x)
+            {
+                break;
+            }
+            x = std::move(y);
+        }
+
+        return x;
+    }
+
+    bool is_perfect_square(const ubint &a)
+    {
+        if (!detail::square_candidate(a))
+        {
+            return false;
+        }
+
+        ubint s, r;
+        sqrtrem(a, s, r);
+        return null(r);
+    }
+
+    bool is_perfect_power(const ubint &a)
+    {
+        if (a.limbs.empty() || (a.limbs.size() == 1 && a.limbs[0] == 1))
+        {
+            return true;
+        }
+
+        // a = 2^t b with b odd. a p-th power needs p to divide t and b to be a
+        // p-th power, and it is enough to try prime p
+        std::size_t t = detail::trailing_zeros(a);
+        ubint b = a >> t;
+        if (b.limbs.size() == 1 && b.limbs[0] == 1)
+        {
+            return t >= 2;
+        }
+
+        if (t == 1)
+        {
+            return false;
+        }
+
+        if (t % 2 == 0 && is_perfect_square(b))
+        {
+            return true;
+        }
+
+        // b mod the primes q below 256. when p divides q - 1, a p-th power
+        // not divisible by q has b^((q - 1) / p) = 1 mod q. a short b skips
+        // this, as its roots cost less than the residues
+        static const std::vector<std::uint64_t> q = detail::primes_upto(255);
+        std::uint64_t res[64] = {};
+        bool filter = b.limbs.size() > 2;
+        for (std::size_t i = 0, j; filter && i < q.size(); i = j)
+        {
+            detail::limb_t m = 1;
+            for (j = i; j < q.size() && m <= ~detail::limb_t(0) / q[j]; j++)
+            {
+                m *= q[j];
+            }
+
+            detail::limb_t r = detail::divrem_1(nullptr, b.limbs.data(), b.limbs.size(), m);
+            for (std::size_t l = i; l < j; l++)
+            {
+                res[l] = r % q[l];
+            }
+        }
+
+        auto residue = [](std::uint64_t x, std::uint64_t e, std::uint64_t m)
+        {
+            std::uint64_t r = 1;
+            for (; e; e >>= 1, x = x * x % m)
+            {
+                if (e & 1)
+                {
+                    r = r * x % m;
+                }
+            }
+            return r;
+        };
+
+        // an odd root is at least 3, so 3^p <= b
+        std::size_t bits = detail::bit_length(b);
+        double lb = detail::log2_approx(b);
+        std::uint64_t bound = (std::uint64_t)(bits / 1.5849625007211562);
+        std::vector<std::uint64_t> primes;
+        if (bound > q.back())
+        {
+            primes = detail::primes_upto(bound);
+        }
+
+        const std::vector<std::uint64_t> &exps = (bound > q.back()) ? primes : q;
+        for (std::size_t i = 1; i < exps.size() && exps[i] <= bound; i++)
+        {
+            std::uint64_t p = exps[i];
+            if (t % p)
+            {
+                continue;
+            }
+
+            bool possible = true;
+            for (std::size_t l = 0; filter && 2 * p < q.back() && l < q.size() && possible; l++)
+            {
+                if ((q[l] - 1) % p == 0 && res[l] && residue(res[l], (q[l] - 1) / p, q[l]) != 1)
+                {
+                    possible = false;
+                }
+            }
+            if (!possible)
+            {
+                continue;
+            }
+
+            // the root is below 2^k, so it equals its 2-adic root mod 2^k. any
+            // other candidate almost always fails on its length or top bits,
+            // and the full power decides the rest
+            std::size_t k = (bits + p - 1) / p;
+            ubint x = detail::root_2adic(b, p, k);
+            std::size_t xb = detail::bit_length(x);
+            if (!xb || (xb - 1) * p >= bits || xb * p < bits)
+            {
+                continue;
+            }
+
+            if (std::fabs(p * detail::log2_approx(x) - lb) > 1e-9 + lb * 1e-13)
+            {
+                continue;
+            }
+
+            if (detail::pow_ui(x, p) == b)
             {
-                --mid;
-                right = mid;
+                return true;
             }
-            mid = 0ULL;
         }
 
-        return v;
+        return false;
+    }
+
+    ubint gcd(const ubint &a, const ubint &b)
+    {
+        ubint x = a, y = b;
+        detail::gcd_reduce(x, y, nullptr);
+        return null(x) ? y : x;
+    }
+
+    ubint lcm(const ubint &a, const ubint &b)
+    {
+        if (a.limbs.empty() || b.limbs.empty())
+        {
+            return ubint(0ULL, a.resource());
+        }
+
+        return a / gcd(a, b) * b;
     }
 
     ubint min(const ubint &a, const ubint &b)
@@ -673,12 +5571,83 @@ namespace estd
 
     ubint factorial(const ubint &n)
     {
-        if (n == 1)
+        std::size_t count;
+        if (!ubint::shift_count(n, count))
         {
-            return 1;
+            throw std::length_error("factorial argument too large");
         }
 
-        return n * factorial(n - 1);
+        return factorial((std::uint64_t)count);
+    }
+
+    ubint factorial(std::uint64_t n)
+    {
+        if (n <= 20)
+        {
+            // 20! is the largest that fits in 64 bits
+            std::uint64_t f = 1;
+            for (std::uint64_t i = 2; i <= n; i++)
+            {
+                f *= i;
+            }
+            return f;
+        }
+
+        // n! = 2^e2 * p^ep * ..., where the power of two is a shift
+        std::vector<std::uint64_t> p = detail::primes_upto(n), e(p.size());
+        for (std::size_t i = 0; i < p.size(); i++)
+        {
+            e[i] = detail::legendre(n, p[i]);
+        }
+
+        std::size_t e2 = e[0];
+        p.erase(p.begin());
+        e.erase(e.begin());
+
+        return detail::prime_power_product(p, e) << e2;
+    }
+
+    ubint binomial(std::uint64_t n, std::uint64_t k)
+    {
+        if (k > n)
+        {
+            return 0ULL;
+        }
+
+        k = std::min(k, n - k);
+        if (k < n / 64)
+        {
+            // far fewer factors than primes up to n, so divide the product of
+            // the top k factors of n! by k! rather than sieving
+            std::vector<std::uint64_t> v(k);
+            for (std::uint64_t i = 0; i < k; i++)
+            {
+                v[i] = n - i;
+            }
+
+            return detail::product(v.data(), v.size()) / factorial(k);
+        }
+
+        // the exponent of p is the number of carries adding k and n - k in
+        // base p, which legendre's formula gives as the difference below
+        std::vector<std::uint64_t> p = detail::primes_upto(n), q, e;
+        for (std::size_t i = 0; i < p.size(); i++)
+        {
+            std::uint64_t x = detail::legendre(n, p[i]) - detail::legendre(k, p[i]) - detail::legendre(n - k, p[i]);
+            if (x)
+            {
+                q.push_back(p[i]);
+                e.push_back(x);
+            }
+        }
+
+        return detail::prime_power_product(q, e);
+    }
+
+    ubint primorial(std::uint64_t n)
+    {
+        std::vector<std::uint64_t> p = detail::primes_upto(n);
+        return detail::product(p.data(), p.size());
     }
 
     ubint map(const ubint &x, const ubint &a, const ubint &b, const ubint &c, const ubint &d)
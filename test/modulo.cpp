@@ -0,0 +1,91 @@
+// checks of bint % and /. both truncate, so the remainder takes the sign of
+// the dividend and a == (a / b) * b + a % b for every sign of a and b
+
+#include <estd.hpp>
+
+#include <cstdio>
+#include <string>
+
+namespace
+{
+    using estd::bint;
+
+    int failures = 0;
+
+    void check(bool ok, const std::string &what)
+    {
+        if (!ok)
+        {
+            std::printf("FAIL %s\n", what.c_str());
+            failures++;
+        }
+    }
+
+    std::string show(const bint &a, const bint &b)
+    {
+        return a.value() + " and " + b.value();
+    }
+
+    // the remainder has the sign of a and is smaller than b in magnitude,
+    // and the quotient and remainder put a back together
+    void check_identity(const bint &a, const bint &b)
+    {
+        bint q = a / b, r = a % b;
+        check(q * b + r == a, "a == (a / b) * b + a % b for " + show(a, b));
+        check((negative(r) ? -r : r) < (negative(b) ? -b : b), "|a % b| < |b| for " + show(a, b));
+        check(null(r) || negative(r) == negative(a), "a % b has the sign of a for " + show(a, b));
+        check(!(null(r) && negative(r)), "a % b is not negative zero for " + show(a, b));
+
+        std::pair<bint, bint> d = divmod(a, b);
+        check(d.first == q && d.second == r, "divmod agrees with / and % for " + show(a, b));
+
+        bint c = a;
+        c %= b;
+        check(c == r, "%= agrees with % for " + show(a, b));
+    }
+}
+
+int main()
+{
+    // the four sign combinations
+    check(bint(7LL) % bint(3LL) == bint(1LL), "7 % 3 == 1");
+    check(bint(-7LL) % bint(3LL) == bint(-1LL), "-7 % 3 == -1");
+    check(bint(7LL) % bint(-3LL) == bint(1LL), "7 % -3 == 1");
+    check(bint(-7LL) % bint(-3LL) == bint(-1LL), "-7 % -3 == -1");
+    check(bint(-7LL) / bint(3LL) == bint(-2LL), "-7 / 3 == -2");
+    check(bint(7LL) / bint(-3LL) == bint(-2LL), "7 / -3 == -2");
+
+    // exact divisions leave zero, never negative zero
+    check(!negative(bint(-6LL) % bint(3LL)), "-6 % 3 is not negative");
+    check(!negative(bint(6LL) % bint(-3LL)), "6 % -3 is not negative");
+
+    // small and multi limb operands of every sign
+    const char *values[] = {
+        "0", "1", "2", "3", "7", "10", "18446744073709551615", "18446744073709551616",
+        "340282366920938463463374607431768211457", "123456789012345678901234567890123456789012345678901234567890",
+    };
+    for (const char *x : values)
+    {
+        for (const char *y : values)
+        {
+            if (std::string(y) == "0")
+            {
+                continue;
+            }
+
+            for (int s = 0; s < 4; s++)
+            {
+                bint a(std::string(s & 1 ? "-" : "") + x), b(std::string(s & 2 ? "-" : "") + y);
+                check_identity(a, b);
+            }
+        }
+    }
+
+    if (failures)
+    {
+        std::printf("%d failures\n", failures);
+        return 1;
+    }
+
+    return 0;
+}